@@ -0,0 +1,141 @@
+/* Summer 2017 */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "utils.h"
+#include "setInCache.h"
+#include "cacheRead.h"
+#include "cacheWrite.h"
+#include "getFromCache.h"
+#include "mem.h"
+#include "cacheBatch.h"
+#include "replacement.h"
+#include "../part2/hitRate.h"
+
+/*
+	Takes in a request and determines whether it could be performed by the
+	typed access of its size. Returns true if the size is supported, the
+	address is aligned, and the whole access is inside physical memory.
+*/
+bool validRequest(cacheRequest_t* request) {
+	uint32_t size = request->size;
+	if (size != 1 && size != 2 && size != 4 && size != 8) {
+		return false;
+	}
+	if (request->op != READ_ACCESS && request->op != WRITE_ACCESS) {
+		return false;
+	}
+	return (request->address & (size - 1)) == 0 && validAddresses(request->address, size);
+}
+
+/*
+	Takes in a cache and a valid request whose size is larger than a block
+	and performs it with the typed access of its size, which splits it into
+	smaller accesses. Fills in the result, which hit only if every access
+	it was split into hit.
+*/
+static void performTyped(cache_t* cache, cacheRequest_t* request, cacheResult_t* result) {
+	double access = cache->access;
+	double hit = cache->hit;
+	if (request->op == WRITE_ACCESS) {
+		switch (request->size) {
+			case 2:
+				writeHalfWord(cache, request->address, (uint16_t) request->data);
+				break;
+			case 4:
+				writeWord(cache, request->address, (uint32_t) request->data);
+				break;
+			default:
+				writeDoubleWord(cache, request->address, request->data);
+				break;
+		}
+	} else {
+		switch (request->size) {
+			case 2:
+				result->data = readHalfWord(cache, request->address).data;
+				break;
+			case 4:
+				result->data = readWord(cache, request->address).data;
+				break;
+			default:
+				result->data = readDoubleWord(cache, request->address).data;
+				break;
+		}
+	}
+	result->hit = cache->access != access && (cache->hit - hit) == (cache->access - access);
+}
+
+/*
+	Takes in a cache, an array of requests, an array of results with the
+	same number of entries, and that number, and performs every request in
+	order, leaving the cache and its statistics exactly as the equivalent
+	sequence of typed reads and writes would. All requests are validated
+	first, and invalid ones are skipped with success set to false. A run of
+	requests in the same block is looked up once, since every request after
+	the first in the run hits. Returns the number of successful requests.
+*/
+uint32_t accessBatch(cache_t* cache, cacheRequest_t* requests, cacheResult_t* results, uint32_t count) {
+	uint32_t successes = 0;
+	uint32_t blockAddress = 0;
+	uint32_t blockNumber = 0;
+	bool resident = false;
+	uint8_t bytes[8];
+	if (requests == NULL || results == NULL) {
+		return 0;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		results[i].success = cache != NULL && validRequest(&requests[i]);
+		results[i].hit = false;
+		results[i].data = 0;
+		successes += results[i].success;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		cacheRequest_t* request = &requests[i];
+		cacheResult_t* result = &results[i];
+		if (!result->success) {
+			continue;
+		}
+		if (request->size > cache->blockDataSize) {
+			performTyped(cache, request, result);
+			resident = false;
+			continue;
+		}
+		uint32_t offset = getOffset(cache, request->address);
+		bool sampled = sampleSet(cache, request->address);
+		if (!sampled) {
+			cache->skipped++;		// Sets that are not sampled go straight to memory
+			resident = false;
+		} else if (resident && request->address - offset == blockAddress) {
+			repeatHits(cache, request->address, 1);		// Same block as the last request, so a hit
+			result->hit = true;
+		} else {
+			double hit = cache->hit;
+			blockNumber = accessBlock(cache, request->address);
+			blockAddress = request->address - offset;
+			resident = true;
+			result->hit = cache->hit != hit;
+		}
+		if (request->op == WRITE_ACCESS) {
+			for (uint32_t j = 0; j < request->size; j++) {
+				bytes[j] = (uint8_t) (request->data >> ((request->size - 1 - j) << 3));
+			}
+			if (!sampled) {
+				writeMemoryRange(cache, request->address, request->size, bytes);
+				continue;
+			}
+			setData(cache, bytes, blockNumber, request->size, offset);
+			setDirty(cache, blockNumber, 1);
+			setShared(cache, blockNumber, 0);
+		} else {
+			if (sampled) {
+				getDataInto(cache, offset, blockNumber, request->size, bytes);
+			} else {
+				readMemoryRange(cache, request->address, request->size, bytes);
+			}
+			for (uint32_t j = 0; j < request->size; j++) {
+				result->data = (result->data << 8) | bytes[j];
+			}
+		}
+	}
+	return successes;
+}
@@ -0,0 +1,22 @@
+/* Summer 2017 */
+#ifndef CACHEBATCH_H
+#define CACHEBATCH_H
+
+/*
+	Takes in a request and determines whether it could be performed by the
+	typed access of its size. Returns true if the size is supported, the
+	address is aligned, and the whole access is inside physical memory.
+*/
+bool validRequest(cacheRequest_t* request);
+
+/*
+	Takes in a cache, an array of requests, an array of results with the
+	same number of entries, and that number, and performs every request in
+	order, leaving the cache and its statistics exactly as the equivalent
+	sequence of typed reads and writes would. All requests are validated
+	first, and invalid ones are skipped with success set to false. A run of
+	requests in the same block is looked up once, since every request after
+	the first in the run hits. Returns the number of successful requests.
+*/
+uint32_t accessBatch(cache_t* cache, cacheRequest_t* requests, cacheResult_t* results, uint32_t count);
+#endif
@@ -2,12 +2,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "utils.h"
 #include "setInCache.h"
 #include "cacheRead.h"
 #include "cacheWrite.h"
 #include "getFromCache.h"
 #include "mem.h"
+#include "replacement.h"
 #include "../part2/hitRate.h"
 
 /*
@@ -15,18 +17,25 @@
 	returning it in a uint8_t* pointer.
 */
 uint8_t* fetchBlock(cache_t* cache, uint32_t blockNumber) {
-	uint64_t location = getDataLocation(cache, blockNumber, 0);
-	uint32_t length = cache->blockDataSize;
-	uint8_t* data = malloc(sizeof(uint8_t) << log_2(length));
+	uint8_t* data = malloc(sizeof(uint8_t) << log_2(cache->blockDataSize));
 	if (data == NULL) {
 		allocationFailed();
 	}
+	fetchBlockInto(cache, blockNumber, data);
+	return data;
+}
+
+/*
+	Takes in a cache, a block number, and a buffer of at least
+	blockDataSize bytes and copies that block of data into the buffer.
+*/
+void fetchBlockInto(cache_t* cache, uint32_t blockNumber, uint8_t* data) {
+	uint64_t location = getDataLocation(cache, blockNumber, 0);
+	uint32_t length = cache->blockDataSize;
 	int shiftAmount = location & 7;
 	uint64_t byteLoc = location >> 3;
 	if (shiftAmount == 0) {
-		for (uint32_t i = 0; i < length; i++) {
-			data[i] = cache->contents[byteLoc + i];
-		}
+		memcpy(data, cache->contents + byteLoc, length);
 	} else {
 		length = length << 3;
 		data[0] = cache->contents[byteLoc] << shiftAmount;
@@ -40,7 +49,6 @@ uint8_t* fetchBlock(cache_t* cache, uint32_t blockNumber) {
 		}
 		data[displacement - 1] = data[displacement - 1] | (cache->contents[byteLoc + displacement] >> (8 - shiftAmount));
 	}
-	return data;
 }
 
 /*
@@ -51,28 +59,81 @@ uint8_t* fetchBlock(cache_t* cache, uint32_t blockNumber) {
 	evicted.
 */
 uint8_t* readFromCache(cache_t* cache, uint32_t address, uint32_t dataSize) {
-	evictionInfo_t* blockInfo = findEviction(cache, address);
+	uint8_t* contents = malloc(sizeof(uint8_t) * dataSize);
+	if (contents == NULL) {
+		allocationFailed();
+	}
+	readFromCacheInto(cache, address, dataSize, contents);
+	return contents;
+}
+
+/*
+	Takes in a cache, an address, a dataSize, and a buffer of at least
+	dataSize bytes and performs the same access as readFromCache, copying
+	the data read into the buffer. Makes no heap allocations.
+*/
+void readFromCacheInto(cache_t* cache, uint32_t address, uint32_t dataSize, uint8_t* data) {
+	if (!sampleSet(cache, address)) {
+		readMemoryRange(cache, address, dataSize, data);
+		cache->skipped++;
+		return;
+	}
+	uint32_t blockNumber = accessBlock(cache, address);
+	getDataInto(cache, getOffset(cache, address), blockNumber, dataSize, data);
+}
+
+/*
+	Takes in a cache and an address and makes the block holding that
+	address present in the cache, counting one access and evicting and
+	filling a block on a miss, then updates the LRUs. Returns the block
+	number now holding the address.
+*/
+uint32_t accessBlock(cache_t* cache, uint32_t address) {
+	evictionInfo_t blockInfo;
 	uint32_t tag = getTag(cache, address);
 	uint32_t idx = getIndex(cache, address);
-	uint8_t* contents;
+	findEvictionInto(cache, address, &blockInfo);
 	reportAccess(cache);
-	if (blockInfo->match == 0) {
-		evict(cache, blockInfo->blockNumber);					// Evict block (update mem and stuff)
-		uint8_t* data = readFromMem(cache, address - getOffset(cache, address));
-		setValid(cache, blockInfo->blockNumber, (uint8_t) 1);
-		setData(cache, data, blockInfo->blockNumber, cache->blockDataSize, 0);
-		setDirty(cache, blockInfo->blockNumber, (uint8_t) 0);
-		setTag(cache, tag, blockInfo->blockNumber);
-		free(data);
+	classifyAccess(cache, address, blockInfo.match);
+	if (blockInfo.match == 0) {
+		evict(cache, blockInfo.blockNumber);					// Evict block (update mem and stuff)
+		setValid(cache, blockInfo.blockNumber, (uint8_t) 1);
+		loadBlockFromMem(cache, blockInfo.blockNumber, address - getOffset(cache, address));
+		setDirty(cache, blockInfo.blockNumber, (uint8_t) 0);
+		setTag(cache, tag, blockInfo.blockNumber);
 	}
 	else { // hit
 		reportHit(cache);
 	}
-	contents = getData(cache, getOffset(cache, address), blockInfo->blockNumber, dataSize);
-	updateLRU(cache, tag, idx, blockInfo->LRU);
-	free(blockInfo);
-	return contents;
+	updateReplacement(cache, tag, idx, &blockInfo);
+	return blockInfo.blockNumber;
+}
 
+/*
+	Takes in a cache, an address, a length, and a buffer of at least length
+	bytes and reads the whole range into the buffer, like memcpy out of
+	memory. Each block touched is looked up once, but the access and hit
+	counts are updated as if the range had been read with the widest
+	aligned typed reads. Returns 0 for a success and -1 if any part of the
+	range is an invalid address.
+*/
+int cacheReadRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data) {
+	if (cache == NULL || data == NULL || (length > 0 && validAddresses(address, length) != 1)) {
+		return -1;
+	}
+	while (length > 0) {
+		uint32_t chunk = cache->blockDataSize - getOffset(cache, address);
+		if (chunk > length) {
+			chunk = length;
+		}
+		uint32_t accesses = countScalarAccesses(cache, address, chunk);
+		readFromCacheInto(cache, address, chunk, data);
+		repeatHits(cache, address, accesses - 1);		// The rest of the block always hits
+		address += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+	return 0;
 }
 
 /*
@@ -89,9 +150,9 @@ byteInfo_t readByte(cache_t* cache, uint32_t address) {
 	if (!retVal.success) {
 		return retVal;
 	}
-	uint8_t* data = readFromCache(cache, address, (uint32_t)1);
+	uint8_t data[1];
+	readFromCacheInto(cache, address, (uint32_t)1, data);
 	retVal.data = *data;
-	free(data);
 	return retVal;
 }
 
@@ -116,9 +177,9 @@ halfWordInfo_t readHalfWord(cache_t* cache, uint32_t address) {
 		}
 		return retVal;
 	}
-	uint8_t* data = readFromCache(cache, address, (uint32_t)2);
+	uint8_t data[2];
+	readFromCacheInto(cache, address, (uint32_t)2, data);
 	retVal.data = (*data << 8) | *(data + 1);
-	free(data);
 	return retVal;
 }
 
@@ -144,11 +205,11 @@ wordInfo_t readWord(cache_t* cache, uint32_t address) {
 		return retVal;
 	}
 
-	uint8_t* data = readFromCache(cache, address, (uint32_t)4);
+	uint8_t data[4];
+	readFromCacheInto(cache, address, (uint32_t)4, data);
 	for (int i = 0; i < 4; i++) {
 		retVal.data = (retVal.data << 8) | *(data + i);
 	}
-	free(data);
 	return retVal;
 }
 
@@ -173,10 +234,10 @@ doubleWordInfo_t readDoubleWord(cache_t* cache, uint32_t address) {
 		}
 		return retVal;
 	}
-	uint8_t* data = readFromCache(cache, address, (uint32_t)8);
+	uint8_t data[8];
+	readFromCacheInto(cache, address, (uint32_t)8, data);
 	for (int i = 0; i < 8; i++) {
 		retVal.data = (retVal.data << 8) | *(data + i);
 	}
-	free(data);
 	return retVal;
 }
@@ -8,6 +8,12 @@
 */
 uint8_t* fetchBlock(cache_t* cache, uint32_t blockNumber);
 
+/*
+	Takes in a cache, a block number, and a buffer of at least
+	blockDataSize bytes and copies that block of data into the buffer.
+*/
+void fetchBlockInto(cache_t* cache, uint32_t blockNumber, uint8_t* data);
+
 /*
 	Takes in a cache, an address, and a dataSize and reads from the cache at
 	that address the number of bytes indicated by the size. If the data block 
@@ -17,6 +23,31 @@ uint8_t* fetchBlock(cache_t* cache, uint32_t blockNumber);
 */
 uint8_t* readFromCache(cache_t* cache, uint32_t address, uint32_t dataSize);
 
+/*
+	Takes in a cache, an address, a dataSize, and a buffer of at least
+	dataSize bytes and performs the same access as readFromCache, copying
+	the data read into the buffer. Makes no heap allocations.
+*/
+void readFromCacheInto(cache_t* cache, uint32_t address, uint32_t dataSize, uint8_t* data);
+
+/*
+	Takes in a cache and an address and makes the block holding that
+	address present in the cache, counting one access and evicting and
+	filling a block on a miss, then updates the LRUs. Returns the block
+	number now holding the address.
+*/
+uint32_t accessBlock(cache_t* cache, uint32_t address);
+
+/*
+	Takes in a cache, an address, a length, and a buffer of at least length
+	bytes and reads the whole range into the buffer, like memcpy out of
+	memory. Each block touched is looked up once, but the access and hit
+	counts are updated as if the range had been read with the widest
+	aligned typed reads. Returns 0 for a success and -1 if any part of the
+	range is an invalid address.
+*/
+int cacheReadRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data);
+
 /*
 	Takes in a cache and an address and fetches a byte of data.
 	Returns a struct containing a bool field of whether or not
@@ -7,6 +7,7 @@
 #include "getFromCache.h"
 #include "mem.h"
 #include "setInCache.h"
+#include "replacement.h"
 #include "../part2/hitRate.h"
 
 /*
@@ -38,22 +39,25 @@ void writeToCache(cache_t* cache, uint32_t address, uint8_t* data, uint32_t data
 	if (data == NULL || cache == NULL) {
 		return;
 	}
-	evictionInfo_t* blockInfo = findEviction(cache, address);
+	if (!sampleSet(cache, address)) {
+		writeMemoryRange(cache, address, dataSize, data);
+		cache->skipped++;
+		return;
+	}
+	evictionInfo_t blockInfo;
+	findEvictionInto(cache, address, &blockInfo);
 	reportAccess(cache);
-	if (blockInfo->match == 1) {
-		//printf("Writing to block %u\n", blockInfo->blockNumber);
-		writeDataToCache(cache, address, data, dataSize, extractTag(cache, blockInfo->blockNumber), blockInfo);
+	classifyAccess(cache, address, blockInfo.match);
+	if (blockInfo.match == 1) {
+		//printf("Writing to block %u\n", blockInfo.blockNumber);
+		writeDataToCache(cache, address, data, dataSize, extractTag(cache, blockInfo.blockNumber), &blockInfo);
 		reportHit(cache);
-		free(blockInfo);
 		return;
 	}
-	evict(cache, blockInfo->blockNumber);												// If it is a miss, evict (write to mem if dirty)
-	uint8_t* memData = readFromMem(cache, address - getOffset(cache, address));			// Get the whole block
-	setData(cache, memData, blockInfo->blockNumber, cache->blockDataSize, 0);			// Write block to cache
-	setTag(cache, getTag(cache, address), blockInfo->blockNumber);						// Set new tag
-	writeDataToCache(cache, address, data, dataSize, extractTag(cache, blockInfo->blockNumber), blockInfo);	// Finally do the writing
-	free(memData);
-	free(blockInfo);
+	evict(cache, blockInfo.blockNumber);												// If it is a miss, evict (write to mem if dirty)
+	loadBlockFromMem(cache, blockInfo.blockNumber, address - getOffset(cache, address));	// Copy the whole block to cache
+	setTag(cache, getTag(cache, address), blockInfo.blockNumber);						// Set new tag
+	writeDataToCache(cache, address, data, dataSize, extractTag(cache, blockInfo.blockNumber), &blockInfo);	// Finally do the writing
 	return;
 }
 
@@ -69,7 +73,34 @@ void writeDataToCache(cache_t* cache, uint32_t address, uint8_t* data, uint32_t
 	setDirty(cache, evictionInfo->blockNumber, 1);
 	setValid(cache, evictionInfo->blockNumber, 1);
 	setShared(cache, evictionInfo->blockNumber, 0);
-	updateLRU(cache, tag, idx, evictionInfo->LRU);
+	updateReplacement(cache, tag, idx, evictionInfo);
+}
+
+/*
+	Takes in a cache, an address, a length, and a pointer to length bytes of
+	data and writes the whole range to the cache, like memcpy into memory.
+	Each block touched is looked up once, but the access and hit counts are
+	updated as if the range had been written with the widest aligned typed
+	writes. Returns 0 for a success and -1 if any part of the range is an
+	invalid address.
+*/
+int cacheWriteRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data) {
+	if (cache == NULL || data == NULL || (length > 0 && validAddresses(address, length) != 1)) {
+		return -1;
+	}
+	while (length > 0) {
+		uint32_t chunk = cache->blockDataSize - getOffset(cache, address);
+		if (chunk > length) {
+			chunk = length;
+		}
+		uint32_t accesses = countScalarAccesses(cache, address, chunk);
+		writeToCache(cache, address, data, chunk);
+		repeatHits(cache, address, accesses - 1);		// The rest of the block always hits
+		address += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+	return 0;
 }
 
 /*
@@ -81,13 +112,7 @@ void writeDataToCache(cache_t* cache, uint32_t address, uint8_t* data, uint32_t
 int writeByte(cache_t* cache, uint32_t address, uint8_t data) {
 	if (cache == NULL || validAddresses(address, (uint32_t) 1) != 1)
 		return -1;
-	uint8_t* dataArray = (uint8_t *) malloc(sizeof(uint8_t));
-	if (dataArray == NULL) {
-		return -1;
-	}
-	*dataArray = data;
-	writeToCache(cache, address, dataArray, (uint32_t) 1);
-	free(dataArray);
+	writeToCache(cache, address, &data, (uint32_t) 1);
 	return 0;
 }
 
@@ -101,10 +126,7 @@ int writeByte(cache_t* cache, uint32_t address, uint8_t data) {
 int writeHalfWord(cache_t* cache, uint32_t address, uint16_t data) {
 	if (cache == NULL || validAddresses(address, (uint32_t) 2) != 1 || (address % 2 != 0))
 		return -1;
-	uint8_t* dataArray = (uint8_t *) malloc(sizeof(uint8_t) * 2);
-	if (dataArray == NULL) {
-		return -1;
-	}
+	uint8_t dataArray[2];
 	int shift = 8;
 	for (int i = 0; i < 2; i++) {
 		*(dataArray + i) = (data >> shift) & 255;
@@ -120,8 +142,6 @@ int writeHalfWord(cache_t* cache, uint32_t address, uint16_t data) {
 	} else {
 		writeToCache(cache, address, dataArray, (uint32_t) 2);
 	}
-
-	free(dataArray);
 	return 0;
 }
 
@@ -135,10 +155,7 @@ int writeHalfWord(cache_t* cache, uint32_t address, uint16_t data) {
 int writeWord(cache_t* cache, uint32_t address, uint32_t data) {
 	if (cache == NULL || validAddresses(address, (uint32_t) 4) != 1 || (address % 4 != 0))
 		return -1;
-	uint8_t* dataArray = (uint8_t *) malloc(sizeof(uint8_t) * 4);
-	if (dataArray == NULL) {
-		return -1;
-	}
+	uint8_t dataArray[4];
 	int shift = 24;
 	for (int i = 0; i < 4; i++) {
 		*(dataArray + i) = (uint8_t)(data >> shift);
@@ -153,7 +170,6 @@ int writeWord(cache_t* cache, uint32_t address, uint32_t data) {
 	} else {
 		writeToCache(cache, address, dataArray, (uint32_t) 4);
 	}
-	free(dataArray);
 	return 0;
 }
 
@@ -167,10 +183,7 @@ int writeWord(cache_t* cache, uint32_t address, uint32_t data) {
 int writeDoubleWord(cache_t* cache, uint32_t address, uint64_t data) {
 	if (cache == NULL || (validAddresses(address, (uint32_t) 8) != 1) || address % 8 != 0)
 		return -1;
-	uint8_t* dataArray = (uint8_t *) malloc(sizeof(uint8_t) * 8);
-	if (dataArray == NULL) {
-		return -1;
-	}
+	uint8_t dataArray[8];
 	int shift = 56;
 	for (int i = 0; i < 8; i++) {
 		*(dataArray + i) = (data >> shift) & 255;
@@ -179,13 +192,12 @@ int writeDoubleWord(cache_t* cache, uint32_t address, uint64_t data) {
 	if (cache->blockDataSize < 8) {
 		int shift = 32;
 		for(uint32_t i = 0; i < 2; i ++) {
-			writeHalfWord(cache, address + (4 * i), (uint16_t) (data >> shift));
+			writeWord(cache, address + (4 * i), (uint32_t) (data >> shift));
 			shift -= 32;
 		}
 	} else {
 		writeToCache(cache, address, dataArray, (uint32_t) 8);
 	}
-	free(dataArray);
 	return 0;
 }
 
@@ -200,11 +212,14 @@ int writeDoubleWord(cache_t* cache, uint32_t address, uint64_t data) {
 void writeWholeBlock(cache_t* cache, uint32_t address, uint32_t evictionBlockNumber, uint8_t* data) {
 	uint32_t idx = getIndex(cache, address);
 	uint32_t tagVal = getTag(cache, address);
-	int oldLRU = getLRU(cache, evictionBlockNumber);
+	evictionInfo_t blockInfo;
+	blockInfo.blockNumber = evictionBlockNumber;
+	blockInfo.LRU = getLRU(cache, evictionBlockNumber);
+	blockInfo.match = 0;
 	evict(cache, evictionBlockNumber);
 	setValid(cache, evictionBlockNumber, 1);
 	setDirty(cache, evictionBlockNumber, 0);
 	setTag(cache, tagVal, evictionBlockNumber);
 	setData(cache, data, evictionBlockNumber, cache->blockDataSize, 0);
-	updateLRU(cache, tagVal, idx, oldLRU);
+	updateReplacement(cache, tagVal, idx, &blockInfo);
 }
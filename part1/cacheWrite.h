@@ -27,6 +27,16 @@ void writeToCache(cache_t* cache, uint32_t address, uint8_t* data, uint32_t data
 */
 void writeDataToCache(cache_t* cache, uint32_t address, uint8_t* data, uint32_t dataSize, uint32_t tag, evictionInfo_t* evictionInfo);
 
+/*
+	Takes in a cache, an address, a length, and a pointer to length bytes of
+	data and writes the whole range to the cache, like memcpy into memory.
+	Each block touched is looked up once, but the access and hit counts are
+	updated as if the range had been written with the widest aligned typed
+	writes. Returns 0 for a success and -1 if any part of the range is an
+	invalid address.
+*/
+int cacheWriteRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data);
+
 /*
 	Takes in a cache, an address, and a byte of data and writes the byte
 	of data to the cache. May evict something if the block is not already
@@ -4,32 +4,43 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <omp.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "utils.h"
 #include "getFromCache.h"
+#include "replacement.h"
 
 /*
 	Takes in a cache and a blocknumber and returns that block's valid bit.
 */
 uint8_t getValid(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBit(cache, numGarbageBits(cache) + blockNumber * totalBlockBits(cache));
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		return (cache->store.flags[blockNumber] & VALID_FLAG) != 0;
+	}
+	return getBit(cache, getValidLocation(cache, blockNumber));
 }
 
 /*
 	Takes in a cache and a blocknumber and returns that block's dirty bit.
 */
 uint8_t getDirty(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBit(cache, numGarbageBits(cache) + blockNumber * totalBlockBits(cache) + 1);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		return (cache->store.flags[blockNumber] & DIRTY_FLAG) != 0;
+	}
+	return getBit(cache, getDirtyLocation(cache, blockNumber));
 }
 
 /*
 	Takes in a cache and a blocknumber and returns that block's shared bit.
 */
 uint8_t getShared(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBit(cache, numGarbageBits(cache) + blockNumber * totalBlockBits(cache) + 2);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		return (cache->store.flags[blockNumber] & SHARED_FLAG) != 0;
+	}
+	return getBit(cache, getSharedLocation(cache, blockNumber));
 }
 
 /*
@@ -48,18 +59,15 @@ uint8_t getBit(cache_t* cache, uint64_t location) {
 	for the block specified.
 */
 long getLRU(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	uint8_t LRUlen = numLRUBits(cache);
+	uint8_t LRUlen = cache->geometry.LRUBits;
+	uint64_t location = getLRULocation(cache, blockNumber);
 	long result = 0;
-	//printf("blockNumber is %u\n", blockNumber);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		return cache->store.LRU[blockNumber];
+	}
 	for (uint8_t i = 0; i < LRUlen; i++) {
-		//printf("The %u bit is %u\n", i, getBit(cache, numGarbageBits(cache) + blockNumber * totalBlockBits(cache) + (uint64_t)3 + i));
-		result = result | getBit(cache, numGarbageBits(cache) + blockNumber * totalBlockBits(cache) + (uint64_t)3 + (uint64_t) i);
-		if (i == LRUlen - 1)
-			break;
-		result = result << 1;
+		result = (result << 1) | getBit(cache, location + i);
 	}
-	// printf("Result is %d\n", result);
 	return result;
 }
 
@@ -70,18 +78,21 @@ long getLRU(cache_t* cache, uint32_t blockNumber) {
 uint32_t extractTag(cache_t* cache, uint32_t blockNumber) {
 	uint64_t location = getTagLocation(cache, blockNumber);
 	uint64_t byteLoc = location >> 3;
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		return cache->store.tags[blockNumber];
+	}
 	int shiftAmount = location & 7;
 	if (shiftAmount != 0) {
 		uint64_t newTag = (((uint64_t)  cache->contents[byteLoc]) << 56) + (((uint64_t) cache->contents[byteLoc + 1]) << 48)
 	 	+ (((uint64_t)  cache->contents[byteLoc + 2]) << 40) + (((uint64_t) cache->contents[byteLoc + 3]) << 32)
 	 	+ (((uint64_t) cache->contents[byteLoc + 4]) << 24);
 	 	newTag = (newTag  << (shiftAmount));
-	 	newTag = newTag >> (64 - getTagSize(cache));
+	 	newTag = newTag >> (64 - cache->geometry.tagBits);
 		return ((uint32_t) newTag);
 	} else {
 		uint32_t newTag = (((uint32_t)  cache->contents[byteLoc]) << 24) + ((uint32_t) cache->contents[byteLoc + 1] << 16)
 	 	+ (((uint32_t)  cache->contents[byteLoc + 2]) << 8) + ((uint32_t) cache->contents[byteLoc + 3]);
-	 	newTag = newTag >> (32 - getTagSize(cache));
+	 	newTag = newTag >> (32 - cache->geometry.tagBits);
 	 	return newTag;
 	}
 }
@@ -91,7 +102,7 @@ uint32_t extractTag(cache_t* cache, uint32_t blockNumber) {
 	for the block specified.
 */
 uint32_t extractIndex(cache_t* cache, uint32_t blockNumber) {
-	return (uint32_t) (blockNumber >> log_2(cache->n));
+	return (uint32_t) (blockNumber >> cache->geometry.waysBits);
 }
 
 /*
@@ -101,12 +112,119 @@ uint32_t extractIndex(cache_t* cache, uint32_t blockNumber) {
 uint32_t extractAddress(cache_t* cache, uint32_t tag, uint32_t blockNumber, uint32_t offset) {
 	/* Your Code Here. */
 
-	uint32_t result = (extractTag(cache, blockNumber) << (32 - getTagSize(cache)));
-	result = result | (extractIndex(cache, blockNumber) << log_2(cache->blockDataSize));
+	uint32_t result = (extractTag(cache, blockNumber) << (32 - cache->geometry.tagBits));
+	result = result | (extractIndex(cache, blockNumber) << cache->geometry.offsetBits);
 	result = result | offset;
 	return result;
 }
 
+/*
+	Takes in a cache using the fast layout, the first block of a set, a tag,
+	and an evictionInfo struct and fills in the struct in the same way as
+	findEviction. The tags and LRUs of the set are scanned several ways at a
+	time, tracking both a valid way with a matching tag and the first way
+	with the highest LRU in the same pass.
+*/
+static void scanSet(cache_t* cache, uint32_t firstBlock, uint32_t tag, evictionInfo_t* info) {
+	uint32_t* tags = cache->store.tags + firstBlock;
+	uint32_t* LRU = cache->store.LRU + firstBlock;
+	uint8_t* flags = cache->store.flags + firstBlock;
+	uint32_t n = cache->n;
+	uint32_t way = 0;
+	uint32_t highestLRU = LRU[0];
+	uint32_t highestWay = 0;
+#if defined(__AVX2__)
+	if (n >= 8) {
+		__m256i target = _mm256_set1_epi32((int) tag);
+		__m256i best = _mm256_setzero_si256();
+		__m256i bestWay = _mm256_setzero_si256();
+		__m256i ways = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		__m256i step = _mm256_set1_epi32(8);
+		uint32_t lanes[8];
+		uint32_t laneWays[8];
+		for (; way + 8 <= n; way += 8) {
+			__m256i tagVector = _mm256_loadu_si256((__m256i*) (tags + way));
+			uint32_t matches = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(tagVector, target)));
+			while (matches) {
+				uint32_t hit = way + __builtin_ctz(matches);
+				if (flags[hit] & VALID_FLAG) {
+					info->match = 1;
+					info->LRU = LRU[hit];
+					info->blockNumber = firstBlock + hit;
+					return;
+				}
+				matches &= matches - 1;
+			}
+			__m256i LRUVector = _mm256_loadu_si256((__m256i*) (LRU + way));
+			__m256i higher = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(LRUVector, best), best), _mm256_set1_epi32(-1));
+			best = _mm256_max_epu32(LRUVector, best);
+			bestWay = _mm256_blendv_epi8(bestWay, ways, higher);
+			ways = _mm256_add_epi32(ways, step);
+		}
+		_mm256_storeu_si256((__m256i*) lanes, best);
+		_mm256_storeu_si256((__m256i*) laneWays, bestWay);
+		for (int i = 0; i < 8; i++) {
+			if (lanes[i] > highestLRU || (lanes[i] == highestLRU && laneWays[i] < highestWay)) {
+				highestLRU = lanes[i];
+				highestWay = laneWays[i];
+			}
+		}
+	}
+#elif defined(__SSE2__)
+	if (n >= 4) {
+		// LRU values fit in 31 bits so the signed compare of SSE2 is enough
+		__m128i target = _mm_set1_epi32((int) tag);
+		__m128i best = _mm_setzero_si128();
+		__m128i bestWay = _mm_setzero_si128();
+		__m128i ways = _mm_setr_epi32(0, 1, 2, 3);
+		__m128i step = _mm_set1_epi32(4);
+		uint32_t lanes[4];
+		uint32_t laneWays[4];
+		for (; way + 4 <= n; way += 4) {
+			__m128i tagVector = _mm_loadu_si128((__m128i*) (tags + way));
+			uint32_t matches = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(tagVector, target)));
+			while (matches) {
+				uint32_t hit = way + __builtin_ctz(matches);
+				if (flags[hit] & VALID_FLAG) {
+					info->match = 1;
+					info->LRU = LRU[hit];
+					info->blockNumber = firstBlock + hit;
+					return;
+				}
+				matches &= matches - 1;
+			}
+			__m128i LRUVector = _mm_loadu_si128((__m128i*) (LRU + way));
+			__m128i higher = _mm_cmpgt_epi32(LRUVector, best);
+			best = _mm_or_si128(_mm_and_si128(higher, LRUVector), _mm_andnot_si128(higher, best));
+			bestWay = _mm_or_si128(_mm_and_si128(higher, ways), _mm_andnot_si128(higher, bestWay));
+			ways = _mm_add_epi32(ways, step);
+		}
+		_mm_storeu_si128((__m128i*) lanes, best);
+		_mm_storeu_si128((__m128i*) laneWays, bestWay);
+		for (int i = 0; i < 4; i++) {
+			if (lanes[i] > highestLRU || (lanes[i] == highestLRU && laneWays[i] < highestWay)) {
+				highestLRU = lanes[i];
+				highestWay = laneWays[i];
+			}
+		}
+	}
+#endif
+	for (; way < n; way++) {
+		if (tags[way] == tag && (flags[way] & VALID_FLAG)) {
+			info->match = 1;
+			info->LRU = LRU[way];
+			info->blockNumber = firstBlock + way;
+			return;
+		} else if (highestLRU < LRU[way]) {
+			highestLRU = LRU[way];
+			highestWay = way;
+		}
+	}
+	info->match = 0;
+	info->LRU = highestLRU;
+	info->blockNumber = firstBlock + highestWay;
+}
+
 /*
 	Takes in a cache and an address and finds the next block that should be
 	used for a cache operation on the address provided. If this address is
@@ -126,12 +244,28 @@ evictionInfo_t* findEviction(cache_t* cache, uint32_t address) {
 		allocationFailed();
 		return NULL;
 	}
+	findEvictionInto(cache, address, info);
+	return info;
+}
 
+/*
+	Takes in a cache, an address, and a pointer to an evictionInfo struct
+	owned by the caller and fills in the struct exactly as findEviction
+	would, without allocating anything.
+*/
+void findEvictionInto(cache_t* cache, uint32_t address, evictionInfo_t* info) {
 	//uint32_t numBlocks = cache->totalDataSize / cache->blockDataSize;
 	//uint32_t blocksPerSet = numBlocks / getNumSets(cache);
 	uint32_t index = getIndex(cache, address);
 	//uint32_t blockNumber = index * blocksPerSet;
 	uint32_t blockNumber = index * cache->n;
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		scanSet(cache, blockNumber, getTag(cache, address), info);
+		if (!info->match) {
+			chooseVictim(cache, blockNumber, info);
+		}
+		return;
+	}
 
 	//printf("Size of LRU is %u\n", numLRUBits(cache));
 	uint32_t highestLRU = getLRU(cache, blockNumber);
@@ -142,7 +276,7 @@ evictionInfo_t* findEviction(cache_t* cache, uint32_t address) {
 			info->match = 1;
 			info->LRU = getLRU(cache, i);
 			info->blockNumber = i;
-			return info;
+			return;
 		} else if (highestLRU < getLRU(cache, i)) {
 			highestLRU = getLRU(cache, i);
 			highestBlock = i;
@@ -151,7 +285,7 @@ evictionInfo_t* findEviction(cache_t* cache, uint32_t address) {
 	info->match = 0;
 	info->LRU = highestLRU;
 	info->blockNumber = highestBlock;
-	return info;
+	chooseVictim(cache, blockNumber, info);
 }
 
 /*
@@ -162,11 +296,12 @@ evictionInfo_t* findEviction(cache_t* cache, uint32_t address) {
 long getLRUAddress(cache_t* cache, uint32_t address){
 	uint32_t tag;
 	uint32_t idx = getIndex(cache, address);
+	uint32_t blockNumberStart = idx << cache->geometry.waysBits;
 	long tempLRU;
+	tag = getTag(cache, address);
 	for (int i = 0; i < cache->n; i++) {
-		tempLRU = getLRU(cache, (idx << log_2(cache->n)) + i);
-		tag = getTag(cache, address);
-		if (tagEquals((idx << log_2(cache->n)) + i, tag, cache)) {
+		tempLRU = getLRU(cache, blockNumberStart + i);
+		if (tagEquals(blockNumberStart + i, tag, cache)) {
 			return tempLRU;
 		}
 	}
@@ -181,18 +316,26 @@ long getLRUAddress(cache_t* cache, uint32_t address){
 */
 uint8_t* getData(cache_t* cache, uint32_t offset, uint32_t blockNumber, uint32_t size) {
 	uint8_t* data;
-	uint8_t mask;
-	uint64_t location = getDataLocation(cache, blockNumber, offset);
-	uint64_t byteLoc = location >> 3;
-	uint8_t shiftAmount = location & 7;
 	data = (uint8_t*) malloc(sizeof(uint8_t) * size);
 	if (data == NULL) {
 		allocationFailed();
 	}
+	getDataInto(cache, offset, blockNumber, size, data);
+	return data;
+}
+
+/*
+	Takes in a cache, an offset, a blocknumber, a size, and a buffer of at
+	least size bytes and copies the data at that offset of the block into
+	the buffer. Has the same assumptions as getData.
+*/
+void getDataInto(cache_t* cache, uint32_t offset, uint32_t blockNumber, uint32_t size, uint8_t* data) {
+	uint8_t mask;
+	uint64_t location = getDataLocation(cache, blockNumber, offset);
+	uint64_t byteLoc = location >> 3;
+	uint8_t shiftAmount = location & 7;
 	if (shiftAmount == 0) {
-		for (uint32_t i = 0; i < size; i++) {
-			data[i] = cache->contents[byteLoc + i];
-		}
+		memcpy(data, cache->contents + byteLoc, size);
 	} else {
 		mask = 0;
 		for (uint8_t j = 0; j < shiftAmount; j++) {
@@ -203,5 +346,4 @@ uint8_t* getData(cache_t* cache, uint32_t offset, uint32_t blockNumber, uint32_t
 			data[i] = data[i] | ((cache->contents[byteLoc + i + 1] >> (8 - shiftAmount)) & mask);
 		}
 	}
-	return data;
 }
@@ -61,6 +61,13 @@ uint32_t extractAddress(cache_t* cache, uint32_t tag, uint32_t blockNumber, uint
 */
 evictionInfo_t* findEviction(cache_t* cache, uint32_t address);
 
+/*
+	Takes in a cache, an address, and a pointer to an evictionInfo struct
+	owned by the caller and fills in the struct exactly as findEviction
+	would, without allocating anything.
+*/
+void findEvictionInto(cache_t* cache, uint32_t address, evictionInfo_t* info);
+
 /*
 	Takes in a cache and an address and returns the LRU
 	value of that address in the cache. Used mostly for testing.
@@ -75,4 +82,11 @@ long getLRUAddress(cache_t* cache, uint32_t address);
 	higher up that calls this function.
 */
 uint8_t* getData(cache_t* cache, uint32_t offset, uint32_t blockNumber, uint32_t size);
+
+/*
+	Takes in a cache, an offset, a blocknumber, a size, and a buffer of at
+	least size bytes and copies the data at that offset of the block into
+	the buffer. Has the same assumptions as getData.
+*/
+void getDataInto(cache_t* cache, uint32_t offset, uint32_t blockNumber, uint32_t size, uint8_t* data);
 #endif
\ No newline at end of file
@@ -3,29 +3,204 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "utils.h"
 #include "cacheRead.h"
+#include "setInCache.h"
 #include "mem.h"
 
+/*
+	List of every memory that is currently open. Used so that caches which
+	are created on the same file share one image.
+*/
+static physicalMemory_t* openMemories = NULL;
+
+/*
+	Takes in a memory offset and a length and returns how many of those
+	bytes actually lie inside the physical address range.
+*/
+static uint32_t boundedLength(uint32_t offset, uint32_t length) {
+	if (offset >= MEMORY_SIZE) {
+		return 0;
+	}
+	return length < MEMORY_SIZE - offset ? length : MEMORY_SIZE - offset;
+}
+
+/*
+	Takes in a hex character and returns its value.
+*/
+static uint8_t hexValue(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return 0;
+}
+
+/*
+	Takes in the text of a physical memory file and decodes it into image.
+	Every byte takes up 3 characters, two hex digits and a space. Returns
+	the number of bytes found in the text.
+*/
+static uint32_t decodeText(char* text, uint64_t length, uint8_t* image) {
+	uint64_t count = (length + 1) / 3;
+	if (count > MEMORY_SIZE) {
+		count = MEMORY_SIZE;
+	}
+	for (uint64_t i = 0; i < count; i++) {
+		image[i] = (hexValue(text[3 * i]) << 4) | hexValue(text[3 * i + 1]);
+	}
+	return (uint32_t) count;
+}
+
+/*
+	Takes in an array of bytes and a count and encodes them into text in
+	the physical memory format. Text must hold 3 characters per byte.
+*/
+static void encodeText(uint8_t* bytes, uint32_t count, char* text) {
+	static const char digits[] = "0123456789abcdef";
+	for (uint32_t i = 0; i < count; i++) {
+		text[3 * i] = digits[bytes[i] >> 4];
+		text[3 * i + 1] = digits[bytes[i] & 15];
+		text[3 * i + 2] = ' ';
+	}
+}
+
+/*
+	Takes in a name and returns true if it names a binary image.
+*/
+static bool isBinaryName(char* name) {
+	size_t length = strlen(name);
+	return length >= 4 && strcmp(name + length - 4, ".bin") == 0;
+}
+
+/*
+	Takes in the name of a text memory file and an image of MEMORY_SIZE bytes
+	and loads the file into the image. Returns the number of bytes the file
+	holds or -1 if it cannot be read.
+*/
+static int64_t loadText(char* name, uint8_t* image) {
+	struct stat info;
+	int fd = open(name, O_RDONLY);
+	if (fd == -1) {
+		return -1;
+	}
+	if (fstat(fd, &info) == -1) {
+		close(fd);
+		return -1;
+	}
+	uint32_t count = 0;
+	if (info.st_size > 0) {
+		char* text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (text == MAP_FAILED) {
+			close(fd);
+			return -1;
+		}
+		count = decodeText(text, info.st_size, image);
+		munmap(text, info.st_size);
+	}
+	close(fd);
+	return count;
+}
+
+/*
+	Takes in the name of a binary memory image and an image of MEMORY_SIZE
+	bytes and reads the file into the image. Returns the number of bytes
+	read or -1 if the file cannot be opened.
+*/
+static int64_t loadBinary(char* name, uint8_t* image) {
+	FILE* binary = fopen(name, "rb");
+	if (binary == NULL) {
+		return -1;
+	}
+	size_t count = fread(image, sizeof(uint8_t), MEMORY_SIZE, binary);
+	fclose(binary);
+	return count;
+}
+
+/*
+	Takes in a file name, a buffer, and a length and writes the buffer to the
+	file starting at the byte position given. Returns 0 on success and -1
+	otherwise.
+*/
+static int writeFileAt(char* name, int flags, char* buffer, uint64_t length, uint64_t position) {
+	int fd = open(name, O_WRONLY | flags, 0644);
+	if (fd == -1) {
+		return -1;
+	}
+	while (length > 0) {
+		ssize_t written = pwrite(fd, buffer, length, position);
+		if (written <= 0) {
+			close(fd);
+			return -1;
+		}
+		buffer += written;
+		position += written;
+		length -= written;
+	}
+	close(fd);
+	return 0;
+}
+
+/*
+	Takes in a memory and marks the bytes between offset and offset + length
+	as changed since the last flush.
+*/
+static void markDirty(physicalMemory_t* memory, uint32_t offset, uint32_t length) {
+	if (offset < memory->dirtyStart) {
+		memory->dirtyStart = offset;
+	}
+	if (offset + length > memory->dirtyEnd) {
+		memory->dirtyEnd = offset + length;
+	}
+}
+
 /*
 	Takes in a cache and a memeory address that is not located in the current
 	cache and fetches it from main memory. 
 */
 uint8_t* readFromMem(cache_t* cache, uint32_t address) {
-	unsigned temp;
-	FILE* memory = fopen(cache->physicalMemoryName, "r");
 	uint8_t* data = malloc(sizeof(uint8_t) * cache->blockDataSize);
 	if (data == NULL) {
 		allocationFailed();
 	}
+	readFromMemInto(cache, address, data);
+	return data;
+}
+
+/*
+	Takes in a cache, a memory address, and a buffer of at least
+	blockDataSize bytes and copies the block at that address from main
+	memory into the buffer. Bytes past the end of memory are zero.
+*/
+void readFromMemInto(cache_t* cache, uint32_t address, uint8_t* data) {
 	address = address - MIN_ADDRESS;
-	fseek(memory, 3 * address, SEEK_SET);
-	for (uint32_t i = 0; i < cache->blockDataSize; i++) {
-		fscanf(memory, "%x", &temp);
-		data[i] = (uint8_t) temp;
+	uint32_t length = boundedLength(address, cache->blockDataSize);
+	memcpy(data, cache->memory->image + address, length);
+	memset(data + length, 0, cache->blockDataSize - length);
+}
+
+/*
+	Takes in a cache, a block number, and a memory address and copies the
+	block at that address from main memory straight into the data of the
+	block specified, without an intermediate buffer.
+*/
+void loadBlockFromMem(cache_t* cache, uint32_t blockNumber, uint32_t address) {
+	uint32_t offset = address - MIN_ADDRESS;
+	if (boundedLength(offset, cache->blockDataSize) < cache->blockDataSize) {
+		uint8_t* data = readFromMem(cache, address);
+		setData(cache, data, blockNumber, cache->blockDataSize, 0);
+		free(data);
+		return;
 	}
-	fclose(memory);
-	return data;
+	setData(cache, cache->memory->image + offset, blockNumber, cache->blockDataSize, 0);
 }
 
 /*
@@ -33,18 +208,35 @@ uint8_t* readFromMem(cache_t* cache, uint32_t address) {
 	block specified to phsyical memory at the address indicated.
 */
 void writeToMem(cache_t* cache, uint32_t blockNumber, uint32_t address) {
-	uint8_t* data = fetchBlock(cache, blockNumber);
-	FILE* physicalMemory = fopen(cache->physicalMemoryName, "r+");
 	address = address - MIN_ADDRESS;
-	fseek(physicalMemory, 3 * address, SEEK_SET);
-	for (int i = 0; i < cache->blockDataSize; i++) {
-		if (data[i] < 16) {
-			fprintf(physicalMemory, "0");
-		}
-		fprintf(physicalMemory, "%x ", data[i]);
+	uint32_t length = boundedLength(address, cache->blockDataSize);
+	if (length == cache->blockDataSize) {
+		fetchBlockInto(cache, blockNumber, cache->memory->image + address);
+	} else {
+		uint8_t* data = fetchBlock(cache, blockNumber);
+		memcpy(cache->memory->image + address, data, length);
+		free(data);
 	}
-	fclose(physicalMemory);
-	free(data);
+	markDirty(cache->memory, address, length);
+}
+
+/*
+	Takes in a cache, a valid address, a length, and a buffer of at least
+	length bytes and reads the bytes straight from main memory, as for an
+	access to a set that is not sampled.
+*/
+void readMemoryRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data) {
+	memcpy(data, cache->memory->image + (address - MIN_ADDRESS), length);
+}
+
+/*
+	Takes in a cache, a valid address, a length, and length bytes of data
+	and writes the bytes straight to main memory, as for an access to a set
+	that is not sampled.
+*/
+void writeMemoryRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data) {
+	memcpy(cache->memory->image + (address - MIN_ADDRESS), data, length);
+	markDirty(cache->memory, address - MIN_ADDRESS, length);
 }
 
 /*
@@ -59,4 +251,261 @@ int validAddresses(uint32_t address, uint32_t length) {
 		return 0;
 	}
 	return 1;
-}
\ No newline at end of file
+}
+
+/*
+	Takes in the name of a physical memory file and returns the memory
+	loaded from it. If a memory for the same file is already open its
+	reference count is incremented and it is returned instead, so all
+	caches using one file see the same contents. Files are compared by
+	device and inode rather than by name, since two different paths can
+	name one file. Files ending in .bin are treated as binary images and
+	every other file as the text format.
+	Returns NULL if the file cannot be loaded.
+*/
+physicalMemory_t* openPhysicalMemory(char* name) {
+	physicalMemory_t* memory;
+	struct stat file;
+	if (stat(name, &file) == -1) {
+		return NULL;
+	}
+	for (memory = openMemories; memory != NULL; memory = memory->next) {
+		if (memory->device == (uint64_t) file.st_dev && memory->inode == (uint64_t) file.st_ino) {
+			memory->references++;
+			return memory;
+		}
+	}
+	memory = malloc(sizeof(physicalMemory_t));
+	if (memory == NULL) {
+		allocationFailed();
+	}
+	memory->name = malloc(strlen(name) + 1);
+	if (memory->name == NULL) {
+		allocationFailed();
+	}
+	strcpy(memory->name, name);
+	memory->device = (uint64_t) file.st_dev;
+	memory->inode = (uint64_t) file.st_ino;
+	memory->binary = isBinaryName(name);
+	memory->private = false;
+	memory->dirtyStart = MEMORY_SIZE;
+	memory->dirtyEnd = 0;
+	memory->references = 1;
+	if (memory->binary) {
+		struct stat info;
+		int fd = open(name, O_RDWR);
+		if (fd == -1 || fstat(fd, &info) == -1 || (info.st_size < MEMORY_SIZE && ftruncate(fd, MEMORY_SIZE) == -1)) {
+			if (fd != -1) {
+				close(fd);
+			}
+			free(memory->name);
+			free(memory);
+			return NULL;
+		}
+		memory->image = mmap(NULL, MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (memory->image == MAP_FAILED) {
+			free(memory->name);
+			free(memory);
+			return NULL;
+		}
+		memory->fileBytes = MEMORY_SIZE;
+	} else {
+		memory->image = calloc(MEMORY_SIZE, sizeof(uint8_t));
+		if (memory->image == NULL) {
+			allocationFailed();
+		}
+		int64_t count = loadText(name, memory->image);
+		if (count == -1) {
+			free(memory->image);
+			free(memory->name);
+			free(memory);
+			return NULL;
+		}
+		memory->fileBytes = (uint32_t) count;
+	}
+	memory->next = openMemories;
+	openMemories = memory;
+	return memory;
+}
+
+/*
+	Takes in the name of a physical memory file, or NULL, and returns a new
+	private memory holding a copy of the file, or all zeros for NULL.
+	Private memories are never shared with other opens of the file and
+	writes to them are never written back, so simulations can run on a
+	memory file without changing it. Returns NULL if the file cannot be
+	loaded.
+*/
+physicalMemory_t* openPrivatePhysicalMemory(char* name) {
+	physicalMemory_t* memory = malloc(sizeof(physicalMemory_t));
+	if (memory == NULL) {
+		allocationFailed();
+	}
+	if (name == NULL) {
+		name = "";
+	}
+	memory->name = malloc(strlen(name) + 1);
+	memory->image = calloc(MEMORY_SIZE, sizeof(uint8_t));
+	if (memory->name == NULL || memory->image == NULL) {
+		allocationFailed();
+	}
+	strcpy(memory->name, name);
+	int64_t count = 0;
+	if (*name != '\0') {
+		count = isBinaryName(name) ? loadBinary(name, memory->image) : loadText(name, memory->image);
+	}
+	if (count == -1) {
+		free(memory->image);
+		free(memory->name);
+		free(memory);
+		return NULL;
+	}
+	memory->device = 0;
+	memory->inode = 0;
+	memory->binary = false;
+	memory->private = true;
+	memory->fileBytes = (uint32_t) count;
+	memory->dirtyStart = MEMORY_SIZE;
+	memory->dirtyEnd = 0;
+	memory->references = 1;
+	memory->next = NULL;
+	return memory;
+}
+
+/*
+	Takes in a memory and returns a new private memory holding a copy of
+	its current contents. Lets every thread of a simulation start from the
+	same image without loading the file again.
+*/
+physicalMemory_t* copyPhysicalMemory(physicalMemory_t* memory) {
+	physicalMemory_t* copy = malloc(sizeof(physicalMemory_t));
+	if (copy == NULL) {
+		allocationFailed();
+	}
+	copy->name = malloc(strlen(memory->name) + 1);
+	copy->image = malloc(MEMORY_SIZE);
+	if (copy->name == NULL || copy->image == NULL) {
+		allocationFailed();
+	}
+	strcpy(copy->name, memory->name);
+	memcpy(copy->image, memory->image, MEMORY_SIZE);
+	copy->binary = false;
+	copy->private = true;
+	copy->fileBytes = memory->fileBytes;
+	copy->dirtyStart = MEMORY_SIZE;
+	copy->dirtyEnd = 0;
+	copy->references = 1;
+	copy->next = NULL;
+	return copy;
+}
+
+/*
+	Takes in a memory and adds a reference to it. Returns the memory so the
+	caller can store it directly.
+*/
+physicalMemory_t* retainPhysicalMemory(physicalMemory_t* memory) {
+	memory->references++;
+	return memory;
+}
+
+/*
+	Takes in a memory and drops one reference to it. When the last
+	reference is released the memory is flushed to its file and freed.
+*/
+void releasePhysicalMemory(physicalMemory_t* memory) {
+	if (memory == NULL || --memory->references > 0) {
+		return;
+	}
+	if (!memory->private) {
+		flushPhysicalMemory(memory);
+		physicalMemory_t** link = &openMemories;
+		while (*link != memory) {
+			link = &(*link)->next;
+		}
+		*link = memory->next;
+	}
+	if (memory->binary) {
+		munmap(memory->image, MEMORY_SIZE);
+	} else {
+		free(memory->image);
+	}
+	free(memory->name);
+	free(memory);
+}
+
+/*
+	Takes in a memory and writes every byte changed since the last flush
+	back to its file.
+*/
+void flushPhysicalMemory(physicalMemory_t* memory) {
+	if (memory->private) {
+		return;
+	}
+	if (memory->binary) {
+		msync(memory->image, MEMORY_SIZE, MS_ASYNC);
+		return;
+	}
+	if (memory->dirtyStart >= memory->dirtyEnd) {
+		return;
+	}
+	// Bytes between the end of the file and the dirty range are written too so the file has no gaps.
+	uint32_t start = memory->dirtyStart < memory->fileBytes ? memory->dirtyStart : memory->fileBytes;
+	uint32_t count = memory->dirtyEnd - start;
+	char* text = malloc((uint64_t) 3 * count);
+	if (text == NULL) {
+		allocationFailed();
+	}
+	encodeText(memory->image + start, count, text);
+	if (writeFileAt(memory->name, 0, text, (uint64_t) 3 * count, (uint64_t) 3 * start) == -1) {
+		physicalMemFailed();
+	} else if (memory->dirtyEnd > memory->fileBytes) {
+		memory->fileBytes = memory->dirtyEnd;
+	}
+	free(text);
+	memory->dirtyStart = MEMORY_SIZE;
+	memory->dirtyEnd = 0;
+}
+
+/*
+	Takes in the name of a text physical memory file and the name of a
+	binary file and writes the contents of the text file to the binary
+	file as a raw image of the whole physical address range. Returns 0
+	on success and -1 if either file cannot be used.
+*/
+int importPhysicalMemory(char* textName, char* binaryName) {
+	uint8_t* image = calloc(MEMORY_SIZE, sizeof(uint8_t));
+	if (image == NULL) {
+		allocationFailed();
+	}
+	int result = -1;
+	if (loadText(textName, image) != -1) {
+		result = writeFileAt(binaryName, O_CREAT | O_TRUNC, (char*) image, MEMORY_SIZE, 0);
+	}
+	free(image);
+	return result;
+}
+
+/*
+	Takes in the name of a binary physical memory image and the name of a
+	text file and writes the image to the text file in the physicalMemory
+	format. Returns 0 on success and -1 if either file cannot be used.
+*/
+int exportPhysicalMemory(char* binaryName, char* textName) {
+	uint8_t* image = calloc(MEMORY_SIZE, sizeof(uint8_t));
+	char* text = malloc((uint64_t) 3 * MEMORY_SIZE);
+	if (image == NULL || text == NULL) {
+		allocationFailed();
+	}
+	int64_t count = loadBinary(binaryName, image);
+	if (count == -1) {
+		free(image);
+		free(text);
+		return -1;
+	}
+	encodeText(image, (uint32_t) count, text);
+	int result = writeFileAt(textName, O_CREAT | O_TRUNC, text, (uint64_t) 3 * count, 0);
+	free(image);
+	free(text);
+	return result;
+}
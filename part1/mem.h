@@ -3,6 +3,7 @@
 #define MEM_H
 #define MIN_ADDRESS 0x61c00000
 #define MAX_ADDRESS 0x61cfffff
+#define MEMORY_SIZE (MAX_ADDRESS - MIN_ADDRESS + 1)
 
 /*
 	Takes in a cache and a memeory address that is not located in the current
@@ -10,12 +11,40 @@
 */
 uint8_t* readFromMem(cache_t* cache, uint32_t address);
 
+/*
+	Takes in a cache, a memory address, and a buffer of at least
+	blockDataSize bytes and copies the block at that address from main
+	memory into the buffer. Bytes past the end of memory are zero.
+*/
+void readFromMemInto(cache_t* cache, uint32_t address, uint8_t* data);
+
+/*
+	Takes in a cache, a block number, and a memory address and copies the
+	block at that address from main memory straight into the data of the
+	block specified, without an intermediate buffer.
+*/
+void loadBlockFromMem(cache_t* cache, uint32_t blockNumber, uint32_t address);
+
 /*
 	Takes in a cache, a block number, and an address and writes the data in the
 	block specified to phsyical memory at the address indicated.
 */
 void writeToMem(cache_t* cache, uint32_t blockNumber, uint32_t address);
 
+/*
+	Takes in a cache, a valid address, a length, and a buffer of at least
+	length bytes and reads the bytes straight from main memory, as for an
+	access to a set that is not sampled.
+*/
+void readMemoryRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data);
+
+/*
+	Takes in a cache, a valid address, a length, and length bytes of data
+	and writes the bytes straight to main memory, as for an access to a set
+	that is not sampled.
+*/
+void writeMemoryRange(cache_t* cache, uint32_t address, uint32_t length, uint8_t* data);
+
 /*
 	Takes in an address and a size that will be requested and determines
 	whether or not that memory is accessible. Returns 1 if the memory is
@@ -23,4 +52,64 @@ void writeToMem(cache_t* cache, uint32_t blockNumber, uint32_t address);
 */
 int validAddresses(uint32_t address, uint32_t length);
 
-#endif
\ No newline at end of file
+/*
+	Takes in the name of a physical memory file and returns the memory
+	loaded from it. If a memory for the same file is already open its
+	reference count is incremented and it is returned instead, so all
+	caches using one file see the same contents. Files ending in .bin
+	are treated as binary images and every other file as the text format.
+	Returns NULL if the file cannot be loaded.
+*/
+physicalMemory_t* openPhysicalMemory(char* name);
+
+/*
+	Takes in the name of a physical memory file, or NULL, and returns a new
+	private memory holding a copy of the file, or all zeros for NULL.
+	Private memories are never shared with other opens of the file and
+	writes to them are never written back, so simulations can run on a
+	memory file without changing it. Returns NULL if the file cannot be
+	loaded.
+*/
+physicalMemory_t* openPrivatePhysicalMemory(char* name);
+
+/*
+	Takes in a memory and returns a new private memory holding a copy of
+	its current contents. Lets every thread of a simulation start from the
+	same image without loading the file again.
+*/
+physicalMemory_t* copyPhysicalMemory(physicalMemory_t* memory);
+
+/*
+	Takes in a memory and adds a reference to it. Returns the memory so the
+	caller can store it directly.
+*/
+physicalMemory_t* retainPhysicalMemory(physicalMemory_t* memory);
+
+/*
+	Takes in a memory and drops one reference to it. When the last
+	reference is released the memory is flushed to its file and freed.
+*/
+void releasePhysicalMemory(physicalMemory_t* memory);
+
+/*
+	Takes in a memory and writes every byte changed since the last flush
+	back to its file.
+*/
+void flushPhysicalMemory(physicalMemory_t* memory);
+
+/*
+	Takes in the name of a text physical memory file and the name of a
+	binary file and writes the contents of the text file to the binary
+	file as a raw image of the whole physical address range. Returns 0
+	on success and -1 if either file cannot be used.
+*/
+int importPhysicalMemory(char* textName, char* binaryName);
+
+/*
+	Takes in the name of a binary physical memory image and the name of a
+	text file and writes the image to the text file in the physicalMemory
+	format. Returns 0 on success and -1 if either file cannot be used.
+*/
+int exportPhysicalMemory(char* binaryName, char* textName);
+
+#endif
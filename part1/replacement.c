@@ -0,0 +1,691 @@
+/* Summer 2017 */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils.h"
+#include "getFromCache.h"
+#include "setInCache.h"
+#include "replacement.h"
+#include "../part2/hitRate.h"
+
+/*
+	Takes in a cache, the first block of a set, and an evictionInfo struct
+	and fills in the first invalid block of the set. Returns false if every
+	block of the set is valid.
+*/
+static bool firstInvalid(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	for (uint32_t i = firstBlock; i < firstBlock + cache->n; i++) {
+		if (!getValid(cache, i)) {
+			info->blockNumber = i;
+			info->LRU = getLRU(cache, i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	Victim function of the policies that evict the first block with the
+	highest LRU field, which the set scan has already filled in, once the
+	set has no invalid blocks.
+*/
+static void scanVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	firstInvalid(cache, firstBlock, info);
+}
+
+/*
+	Sizing function of the policies that keep log2(n) bits for every block.
+*/
+static uint8_t waysBlockBits(cache_t* cache) {
+	return log_2(cache->n);
+}
+
+/*
+	Sizing function of the policies that keep a log2(n) bit way number for
+	every set.
+*/
+static uint32_t waysSetBits(cache_t* cache) {
+	return log_2(cache->n);
+}
+
+/*
+	Sizing function of the policies that store a way number for every set.
+*/
+static uint32_t waySetBytes(cache_t* cache) {
+	return sizeof(uint32_t);
+}
+
+/*
+	Sizing function of the policies that keep a single bit for every block.
+*/
+static uint8_t oneBlockBit(cache_t* cache) {
+	return 1;
+}
+
+/*
+	Hit and fill function of LRU and fill function of FIFO. The block
+	becomes the youngest of its set and every younger block ages by one.
+*/
+static void lruUpdate(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	updateLRU(cache, tag, idx, info->LRU);
+}
+
+/*
+	Invalidate function of LRU and FIFO. The block becomes the oldest of its
+	set and every valid block older than it gets one younger.
+*/
+static void lruInvalidate(cache_t* cache, uint32_t blockNumber) {
+	long oldLRU = getLRU(cache, blockNumber);
+	uint32_t firstBlock = blockNumber & ~(cache->n - 1);
+	for (uint32_t i = firstBlock; i < firstBlock + cache->n; i++) {
+		if (i == blockNumber) {
+			setLRU(cache, i, cache->n - 1);
+		} else if (getValid(cache, i)) {
+			long currLRU = getLRU(cache, i);
+			if (currLRU > oldLRU) {
+				setLRU(cache, i, currLRU - 1);
+			}
+		}
+	}
+}
+
+/*
+	Sizing functions of PLRU, which keeps a tree of n - 1 bits for every
+	set and stores one byte per node.
+*/
+static uint8_t plruBlockBits(cache_t* cache) {
+	return 0;
+}
+
+static uint32_t plruSetBits(cache_t* cache) {
+	return cache->n - 1;
+}
+
+/*
+	Takes in a cache and a block number and returns the tree of its set.
+	Node i of the tree is entry i - 1, its children are nodes 2i and
+	2i + 1, and way w is the leaf n + w. A node holds 0 when the next
+	victim is under its left child and 1 when it is under its right child.
+*/
+static uint8_t* plruTree(cache_t* cache, uint32_t blockNumber) {
+	return cache->policyState + (uint64_t) (blockNumber >> cache->geometry.waysBits) * cache->geometry.setStateBytes;
+}
+
+/*
+	Takes in a cache and a block number and points every node above the
+	block away from it, so it is the most recently used way of its set.
+*/
+static void plruTouch(cache_t* cache, uint32_t blockNumber) {
+	uint8_t* tree = plruTree(cache, blockNumber);
+	uint32_t node = cache->n + (blockNumber & (cache->n - 1));
+	while (node > 1) {
+		tree[(node >> 1) - 1] = !(node & 1);
+		node >>= 1;
+	}
+}
+
+/*
+	Hit and fill function of PLRU.
+*/
+static void plruUpdate(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	plruTouch(cache, info->blockNumber);
+}
+
+/*
+	Invalidate function of PLRU. Points every node above the block towards
+	it, so it is the next victim of its set.
+*/
+static void plruPointAt(cache_t* cache, uint32_t blockNumber) {
+	uint8_t* tree = plruTree(cache, blockNumber);
+	uint32_t node = cache->n + (blockNumber & (cache->n - 1));
+	while (node > 1) {
+		tree[(node >> 1) - 1] = node & 1;
+		node >>= 1;
+	}
+}
+
+/*
+	Victim function of PLRU. Follows the tree of the set down to the way it
+	points at.
+*/
+static void plruVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	if (firstInvalid(cache, firstBlock, info)) {
+		return;
+	}
+	uint8_t* tree = plruTree(cache, firstBlock);
+	uint32_t node = 1;
+	while (node < cache->n) {
+		node = (node << 1) | tree[node - 1];
+	}
+	info->blockNumber = firstBlock + node - cache->n;
+	info->LRU = getLRU(cache, info->blockNumber);
+}
+
+/*
+	Sizing function of the RRIP policies.
+*/
+static uint8_t rripBlockBits(cache_t* cache) {
+	return RRIP_BITS;
+}
+
+/*
+	Reset function of the RRIP policies.
+*/
+static void rripReset(cache_t* cache) {
+	cache->policySelector = 1 << (RRIP_SELECTOR_BITS - 1);
+	cache->policyFills = 0;
+}
+
+/*
+	Takes in a cache, the first block of a set, and an amount and adds the
+	amount to the prediction of every block in the set. Used to age a set
+	until its highest prediction is RRIP_MAX, so no block saturates.
+*/
+static void rripAge(cache_t* cache, uint32_t firstBlock, uint32_t amount) {
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		uint32_t* LRU = cache->store.LRU + firstBlock;
+		for (uint32_t way = 0; way < cache->n; way++) {
+			LRU[way] += amount;
+		}
+		return;
+	}
+	for (uint32_t i = firstBlock; i < firstBlock + cache->n; i++) {
+		setLRU(cache, i, getLRU(cache, i) + amount);
+	}
+}
+
+/*
+	Takes in a cache and the index of a set and returns the policy that
+	DRRIP uses to insert into the set. Leader sets always use their own
+	policy and update the selector on every miss, and the other sets use
+	BRRIP once the SRRIP leaders have missed more than the BRRIP leaders.
+*/
+static enum replacementPolicy rripDuel(cache_t* cache, uint32_t idx) {
+	uint32_t spacing = cache->geometry.numSets < RRIP_LEADER_SPACING ? cache->geometry.numSets : RRIP_LEADER_SPACING;
+	uint32_t maxSelector = (1 << RRIP_SELECTOR_BITS) - 1;
+	if (idx % spacing == 0) {
+		if (cache->policySelector < maxSelector) {
+			cache->policySelector++;
+		}
+		return SRRIP_POLICY;
+	} else if (idx % spacing == spacing / 2) {
+		if (cache->policySelector > 0) {
+			cache->policySelector--;
+		}
+		return BRRIP_POLICY;
+	}
+	return cache->policySelector > (1 << (RRIP_SELECTOR_BITS - 1)) ? BRRIP_POLICY : SRRIP_POLICY;
+}
+
+/*
+	Hit function of the RRIP policies. The block is predicted to be reused
+	in the near future.
+*/
+static void rripHit(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	setLRU(cache, info->blockNumber, 0);
+}
+
+/*
+	Fill function of the RRIP policies. If the set had to be searched for a
+	victim it is first aged so the victim held RRIP_MAX, then the new block
+	gets the prediction of the policy used for the set.
+*/
+static void rripFill(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	enum replacementPolicy policy = cache->policy;
+	uint32_t prediction = RRIP_MAX - 1;
+	if (info->LRU < RRIP_MAX) {
+		rripAge(cache, idx * cache->n, RRIP_MAX - info->LRU);
+	}
+	if (policy == DRRIP_POLICY) {
+		policy = rripDuel(cache, idx);
+	}
+	if (policy == BRRIP_POLICY) {
+		cache->policyFills = (cache->policyFills + 1) % RRIP_BIMODAL_PERIOD;
+		if (cache->policyFills != 0) {
+			prediction = RRIP_MAX;
+		}
+	}
+	setLRU(cache, info->blockNumber, prediction);
+}
+
+/*
+	Invalidate function of the RRIP policies. The block is predicted to be
+	reused in the distant future.
+*/
+static void rripInvalidate(cache_t* cache, uint32_t blockNumber) {
+	setLRU(cache, blockNumber, RRIP_MAX);
+}
+
+/*
+	Takes in the state of the random number generator and returns the next
+	state, which is also the next random number.
+*/
+static uint32_t nextRandom(uint32_t state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/*
+	Reset function of RANDOM. The generator restarts from the seed, which
+	cannot be 0 as 0 never changes.
+*/
+static void randomReset(cache_t* cache) {
+	cache->policyRandom = cache->policySeed != 0 ? cache->policySeed : 1;
+}
+
+/*
+	Victim function of RANDOM. Uses the next random number without
+	advancing the generator, which is left to the fill.
+*/
+static void randomVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	if (firstInvalid(cache, firstBlock, info)) {
+		return;
+	}
+	info->blockNumber = firstBlock + nextRandom(cache->policyRandom) % cache->n;
+	info->LRU = getLRU(cache, info->blockNumber);
+}
+
+/*
+	Fill function of RANDOM.
+*/
+static void randomFill(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	cache->policyRandom = nextRandom(cache->policyRandom);
+}
+
+/*
+	Sizing function of LFU. The LRU field holds LFU_MAX minus the number of
+	uses, so the set scan finds the least frequently used block.
+*/
+static uint8_t lfuBlockBits(cache_t* cache) {
+	return LFU_BITS;
+}
+
+/*
+	Hit function of LFU. Counts the use until the count saturates.
+*/
+static void lfuHit(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	long field = getLRU(cache, info->blockNumber);
+	if (field > 0) {
+		setLRU(cache, info->blockNumber, field - 1);
+	}
+}
+
+/*
+	Fill function of LFU. The new block has been used once.
+*/
+static void lfuFill(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	setLRU(cache, info->blockNumber, LFU_MAX - 1);
+}
+
+/*
+	Invalidate function of LFU. The block has never been used.
+*/
+static void lfuInvalidate(cache_t* cache, uint32_t blockNumber) {
+	setLRU(cache, blockNumber, LFU_MAX);
+}
+
+/*
+	Takes in a cache and the index of a set and returns the hand of the
+	set, the way CLOCK looks at first.
+*/
+static uint32_t* clockHand(cache_t* cache, uint32_t idx) {
+	return (uint32_t*) cache->policyState + idx;
+}
+
+/*
+	Reset function of CLOCK. Clears every reference bit, which clearCache
+	sets along with the rest of the LRU field.
+*/
+static void clockReset(cache_t* cache) {
+	for (uint32_t i = 0; i < cache->geometry.numBlocks; i++) {
+		setLRU(cache, i, 0);
+	}
+}
+
+/*
+	Victim function of CLOCK. Picks the first way from the hand on without
+	its reference bit set, or the hand if every bit is set, in which case
+	the fill clears them all. Invalid blocks never have their bit set, so
+	they are found without a separate search.
+*/
+static void clockVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	uint32_t hand = *clockHand(cache, firstBlock >> cache->geometry.waysBits);
+	info->blockNumber = firstBlock + hand;
+	for (uint32_t i = 0; i < cache->n; i++) {
+		uint32_t way = (hand + i) & (cache->n - 1);
+		if (getLRU(cache, firstBlock + way) == 0) {
+			info->blockNumber = firstBlock + way;
+			break;
+		}
+	}
+	info->LRU = getLRU(cache, info->blockNumber);
+}
+
+/*
+	Hit function of CLOCK.
+*/
+static void clockHit(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	setLRU(cache, info->blockNumber, 1);
+}
+
+/*
+	Fill function of CLOCK. Clears the reference bits the hand swept past
+	on the way to the victim and moves the hand past the new block.
+*/
+static void clockFill(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	uint32_t firstBlock = idx * cache->n;
+	uint32_t* hand = clockHand(cache, idx);
+	uint32_t victim = info->blockNumber - firstBlock;
+	uint32_t way = *hand;
+	if (info->LRU != 0) {
+		// Every bit was set, so the hand went all the way around
+		for (uint32_t i = firstBlock; i < firstBlock + cache->n; i++) {
+			setLRU(cache, i, 0);
+		}
+	}
+	while (way != victim) {
+		setLRU(cache, firstBlock + way, 0);
+		way = (way + 1) & (cache->n - 1);
+	}
+	setLRU(cache, info->blockNumber, 1);
+	*hand = (victim + 1) & (cache->n - 1);
+}
+
+/*
+	Invalidate function of CLOCK.
+*/
+static void clockInvalidate(cache_t* cache, uint32_t blockNumber) {
+	setLRU(cache, blockNumber, 0);
+}
+
+/*
+	Hit and fill function of NRU. The LRU field holds 1 for a block that
+	has not been used recently. The block is marked used, and once every
+	block of the set is used the others are marked unused again.
+*/
+static void nruUpdate(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	uint32_t firstBlock = idx * cache->n;
+	setLRU(cache, info->blockNumber, 0);
+	for (uint32_t i = firstBlock; i < firstBlock + cache->n; i++) {
+		if (getLRU(cache, i) != 0) {
+			return;
+		}
+	}
+	for (uint32_t i = firstBlock; i < firstBlock + cache->n; i++) {
+		if (i != info->blockNumber) {
+			setLRU(cache, i, 1);
+		}
+	}
+}
+
+/*
+	Invalidate function of NRU.
+*/
+static void nruInvalidate(cache_t* cache, uint32_t blockNumber) {
+	setLRU(cache, blockNumber, 1);
+}
+
+/*
+	Sizing function of OPT, which stores the next use of every block. It
+	models no hardware, so it counts no bits.
+*/
+static uint32_t optSetBytes(cache_t* cache) {
+	return cache->n * sizeof(uint32_t);
+}
+
+/*
+	Takes in a cache and a block number and returns where the next use of
+	the block is stored.
+*/
+static uint32_t* optSlot(cache_t* cache, uint32_t blockNumber) {
+	return (uint32_t*) cache->policyState + blockNumber;
+}
+
+/*
+	Reset function of OPT. The next uses are replayed from the start.
+*/
+static void optReset(cache_t* cache) {
+	cache->usePosition = 0;
+}
+
+/*
+	Victim function of OPT. Evicts the first block whose next use is
+	furthest away.
+*/
+static void optVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	if (firstInvalid(cache, firstBlock, info)) {
+		return;
+	}
+	uint32_t* slots = optSlot(cache, firstBlock);
+	uint32_t furthest = 0;
+	for (uint32_t way = 1; way < cache->n; way++) {
+		if (slots[way] > slots[furthest]) {
+			furthest = way;
+		}
+	}
+	info->blockNumber = firstBlock + furthest;
+	info->LRU = getLRU(cache, info->blockNumber);
+}
+
+/*
+	Hit and fill function of OPT. Stores the next use of the access in the
+	block. Accesses past the end of the next uses are taken as never used
+	again.
+*/
+static void optUpdate(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	uint32_t next = OPT_NEVER;
+	if (cache->usePosition < cache->uses) {
+		next = cache->nextUses[cache->usePosition];
+	}
+	cache->usePosition++;
+	*optSlot(cache, info->blockNumber) = next;
+}
+
+/*
+	Invalidate function of OPT.
+*/
+static void optInvalidate(cache_t* cache, uint32_t blockNumber) {
+	*optSlot(cache, blockNumber) = OPT_NEVER;
+}
+
+/*
+	The replacement policies, in the order of enum replacementPolicy.
+*/
+static const replacementEngine_t engines[] = {
+	[LRU_POLICY] = {"lru", waysBlockBits, NULL, NULL, 0, NULL, NULL,
+		lruUpdate, lruUpdate, lruInvalidate, false},
+	[PLRU_POLICY] = {"plru", plruBlockBits, plruSetBits, plruSetBits, 0, NULL, plruVictim,
+		plruUpdate, plruUpdate, plruPointAt, false},
+	[SRRIP_POLICY] = {"srrip", rripBlockBits, NULL, NULL, 0, rripReset, scanVictim,
+		rripHit, rripFill, rripInvalidate, false},
+	[BRRIP_POLICY] = {"brrip", rripBlockBits, NULL, NULL, RRIP_BIMODAL_BITS, rripReset, scanVictim,
+		rripHit, rripFill, rripInvalidate, false},
+	[DRRIP_POLICY] = {"drrip", rripBlockBits, NULL, NULL, RRIP_BIMODAL_BITS + RRIP_SELECTOR_BITS, rripReset, scanVictim,
+		rripHit, rripFill, rripInvalidate, false},
+	[FIFO_POLICY] = {"fifo", waysBlockBits, NULL, NULL, 0, NULL, scanVictim,
+		NULL, lruUpdate, lruInvalidate, false},
+	[RANDOM_POLICY] = {"random", NULL, NULL, NULL, RANDOM_BITS, randomReset, randomVictim,
+		NULL, randomFill, NULL, false},
+	[LFU_POLICY] = {"lfu", lfuBlockBits, NULL, NULL, 0, NULL, scanVictim,
+		lfuHit, lfuFill, lfuInvalidate, true},
+	[CLOCK_POLICY] = {"clock", oneBlockBit, waysSetBits, waySetBytes, 0, clockReset, clockVictim,
+		clockHit, clockFill, clockInvalidate, false},
+	[NRU_POLICY] = {"nru", oneBlockBit, NULL, NULL, 0, NULL, scanVictim,
+		nruUpdate, nruUpdate, nruInvalidate, false},
+	[OPT_POLICY] = {"opt", NULL, NULL, optSetBytes, 0, optReset, optVictim,
+		optUpdate, optUpdate, optInvalidate, true},
+};
+
+/*
+	Takes in a policy and returns whether createCacheWithOptions supports it.
+*/
+bool validPolicy(enum replacementPolicy policy) {
+	return policy >= LRU_POLICY && policy < sizeof(engines) / sizeof(engines[0]);
+}
+
+/*
+	Takes in a policy and returns the engine that implements it, or NULL if
+	the policy is not valid.
+*/
+const replacementEngine_t* policyEngine(enum replacementPolicy policy) {
+	return validPolicy(policy) ? &engines[policy] : NULL;
+}
+
+/*
+	Takes in a name and a pointer to a policy and sets the policy whose
+	engine has that name. Returns false if there is no such policy.
+*/
+bool findPolicy(char* name, enum replacementPolicy* policy) {
+	for (int i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+		if (strcmp(name, engines[i].name) == 0) {
+			*policy = (enum replacementPolicy) i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bits of state its policy keeps for every block, which is stored in the
+	LRU field of the block.
+*/
+uint8_t policyBlockBits(cache_t* cache) {
+	return cache->engine->blockBits != NULL ? cache->engine->blockBits(cache) : 0;
+}
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bits of state its policy keeps for every set in the modeled hardware.
+*/
+uint32_t policySetBits(cache_t* cache) {
+	return cache->engine->setBits != NULL ? cache->engine->setBits(cache) : 0;
+}
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bits of state its policy keeps for the whole cache in the modeled
+	hardware.
+*/
+uint32_t policyCacheBits(cache_t* cache) {
+	return cache->engine->cacheBits;
+}
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bytes policyState uses to store the state of every set.
+*/
+uint32_t policySetBytes(cache_t* cache) {
+	return cache->engine->setBytes != NULL ? cache->engine->setBytes(cache) : 0;
+}
+
+/*
+	Takes in a cache whose geometry has been computed and allocates the per
+	set state of its policy.
+*/
+void createPolicyState(cache_t* cache) {
+	uint64_t bytes = (uint64_t) cache->geometry.numSets * cache->geometry.setStateBytes;
+	cache->policyState = NULL;
+	if (bytes > 0) {
+		cache->policyState = calloc(bytes, sizeof(uint8_t));
+		if (cache->policyState == NULL) {
+			allocationFailed();
+		}
+	}
+}
+
+/*
+	Takes in a cache and resets the state of its policy, as when the cache
+	is cleared.
+*/
+void resetPolicyState(cache_t* cache) {
+	if (cache->policyState != NULL) {
+		memset(cache->policyState, 0, (uint64_t) cache->geometry.numSets * cache->geometry.setStateBytes);
+	}
+	if (cache->engine->reset != NULL) {
+		cache->engine->reset(cache);
+	}
+}
+
+/*
+	Takes in a cache, the first block of a set, and an evictionInfo struct
+	for an address that missed in that set, filled in by the set scan with
+	the first block with the highest LRU field, and replaces the block with
+	the one the policy evicts next.
+*/
+void chooseVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info) {
+	info->match = 0;
+	if (cache->engine->victim != NULL) {
+		cache->engine->victim(cache, firstBlock, info);
+	}
+}
+
+/*
+	Takes in a cache, the tag and index of an address that was just read
+	or written, and the evictionInfo found for it and updates the
+	replacement state. info->match tells a hit from a fill.
+*/
+void updateReplacement(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info) {
+	if (info->match) {
+		if (cache->engine->hit != NULL) {
+			cache->engine->hit(cache, tag, idx, info);
+		}
+	} else if (cache->engine->fill != NULL) {
+		cache->engine->fill(cache, tag, idx, info);
+	}
+}
+
+/*
+	Takes in a cache, an address whose block was just accessed, and a count
+	and counts that many more accesses that hit the block without looking
+	it up again, as for the rest of a range or of a run in a batch.
+	Policies that count every hit also see each of them.
+*/
+void repeatHits(cache_t* cache, uint32_t address, uint32_t count) {
+	evictionInfo_t blockInfo;
+	if (count == 0) {
+		return;
+	}
+	if (!sampleSet(cache, address)) {
+		cache->skipped += count;
+		return;
+	}
+	if (cache->engine->repeatedHits) {
+		findEvictionInto(cache, address, &blockInfo);
+		for (uint32_t i = 0; i < count; i++) {
+			cache->engine->hit(cache, getTag(cache, address), getIndex(cache, address), &blockInfo);
+		}
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		reportAccess(cache);
+		reportHit(cache);
+	}
+}
+
+/*
+	Takes in a cache using OPT_POLICY, an array, and the number of entries
+	in it and gives the cache the next use of every access it will make.
+	Entry i is the index of the next access to the block of access i, or
+	OPT_NEVER, counting every lookup and every access that reuses the block
+	of the previous one in a batch. The array stays owned by the caller and
+	is replayed from the start whenever the cache is cleared.
+*/
+void setNextUses(cache_t* cache, uint32_t* nextUses, uint64_t count) {
+	cache->nextUses = nextUses;
+	cache->uses = count;
+	cache->usePosition = 0;
+}
+
+/*
+	Takes in a cache and a block number that was just invalidated and
+	updates the replacement state, usually so the block is the next to be
+	evicted from its set.
+*/
+void invalidateReplacement(cache_t* cache, uint32_t blockNumber) {
+	if (cache->engine->invalidate != NULL) {
+		cache->engine->invalidate(cache, blockNumber);
+	}
+}
@@ -0,0 +1,127 @@
+/* Summer 2017 */
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+/*
+	Settings of the RRIP policies. Predictions are RRIP_BITS wide, so a
+	block predicted to be reused in the distant future holds RRIP_MAX.
+	BRRIP inserts with a long prediction once every RRIP_BIMODAL_PERIOD
+	fills, counted in RRIP_BIMODAL_BITS. DRRIP makes one set in every
+	RRIP_LEADER_SPACING a leader for SRRIP and one a leader for BRRIP and
+	keeps a RRIP_SELECTOR_BITS wide counter of which leaders miss more.
+*/
+#define RRIP_BITS 2
+#define RRIP_MAX ((1 << RRIP_BITS) - 1)
+#define RRIP_BIMODAL_PERIOD 32
+#define RRIP_BIMODAL_BITS 5
+#define RRIP_LEADER_SPACING 32
+#define RRIP_SELECTOR_BITS 10
+
+/*
+	Width of the use counts of LFU, which saturate at LFU_MAX, and of the
+	generator RANDOM uses.
+*/
+#define LFU_BITS 4
+#define LFU_MAX ((1 << LFU_BITS) - 1)
+#define RANDOM_BITS 32
+
+/*
+	Next use of an access whose block is never used again.
+*/
+#define OPT_NEVER UINT32_MAX
+
+/*
+	Takes in a policy and returns whether createCacheWithOptions supports it.
+*/
+bool validPolicy(enum replacementPolicy policy);
+
+/*
+	Takes in a policy and returns the engine that implements it, or NULL if
+	the policy is not valid.
+*/
+const replacementEngine_t* policyEngine(enum replacementPolicy policy);
+
+/*
+	Takes in a name and a pointer to a policy and sets the policy whose
+	engine has that name. Returns false if there is no such policy.
+*/
+bool findPolicy(char* name, enum replacementPolicy* policy);
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bits of state its policy keeps for every block, which is stored in the
+	LRU field of the block.
+*/
+uint8_t policyBlockBits(cache_t* cache);
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bits of state its policy keeps for every set in the modeled hardware.
+*/
+uint32_t policySetBits(cache_t* cache);
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bits of state its policy keeps for the whole cache in the modeled
+	hardware.
+*/
+uint32_t policyCacheBits(cache_t* cache);
+
+/*
+	Takes in a cache whose engine and n are set and returns the number of
+	bytes policyState uses to store the state of every set.
+*/
+uint32_t policySetBytes(cache_t* cache);
+
+/*
+	Takes in a cache whose geometry has been computed and allocates the per
+	set state of its policy.
+*/
+void createPolicyState(cache_t* cache);
+
+/*
+	Takes in a cache and resets the state of its policy, as when the cache
+	is cleared.
+*/
+void resetPolicyState(cache_t* cache);
+
+/*
+	Takes in a cache, the first block of a set, and an evictionInfo struct
+	for an address that missed in that set, filled in by the set scan with
+	the first block with the highest LRU field, and replaces the block with
+	the one the policy evicts next.
+*/
+void chooseVictim(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info);
+
+/*
+	Takes in a cache, the tag and index of an address that was just read
+	or written, and the evictionInfo found for it and updates the
+	replacement state. info->match tells a hit from a fill.
+*/
+void updateReplacement(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info);
+
+/*
+	Takes in a cache, an address whose block was just accessed, and a count
+	and counts that many more accesses that hit the block without looking
+	it up again, as for the rest of a range or of a run in a batch.
+	Policies that count every hit also see each of them.
+*/
+void repeatHits(cache_t* cache, uint32_t address, uint32_t count);
+
+/*
+	Takes in a cache using OPT_POLICY, an array, and the number of entries
+	in it and gives the cache the next use of every access it will make.
+	Entry i is the index of the next access to the block of access i, or
+	OPT_NEVER, counting every lookup and every access that reuses the block
+	of the previous one in a batch. The array stays owned by the caller and
+	is replayed from the start whenever the cache is cleared.
+*/
+void setNextUses(cache_t* cache, uint32_t* nextUses, uint64_t count);
+
+/*
+	Takes in a cache and a block number that was just invalidated and
+	updates the replacement state, usually so the block is the next to be
+	evicted from its set.
+*/
+void invalidateReplacement(cache_t* cache, uint32_t blockNumber);
+#endif
@@ -2,17 +2,36 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include "utils.h"
 #include "setInCache.h"
 #include "getFromCache.h"
 #include "cacheWrite.h"
+#include "replacement.h"
+#include "../part2/hitRate.h"
 //#include <stdio.h>
+/*
+	Takes in a cache using the fast layout, a block number, a flag, and a
+	value (either 1 or 0) and sets that flag in the tag store.
+*/
+static void setFlag(cache_t* cache, uint32_t blockNumber, uint8_t flag, uint8_t value) {
+	if (value) {
+		cache->store.flags[blockNumber] |= flag;
+	} else {
+		cache->store.flags[blockNumber] &= ~flag;
+	}
+}
+
 /*
 	Takes in a cache and block number and value (either 1 or 0) and sets
 	the valid bit at that block number to the value given.
 */
 void setValid(cache_t* cache, uint32_t blockNumber, uint8_t value) {
-	setBit(cache, numGarbageBits(cache) + blockNumber * totalBlockBits(cache), value);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		setFlag(cache, blockNumber, VALID_FLAG, value);
+		return;
+	}
+	setBit(cache, getValidLocation(cache, blockNumber), value);
 }
 
 /*
@@ -20,7 +39,11 @@ void setValid(cache_t* cache, uint32_t blockNumber, uint8_t value) {
 	the dirty bit at that block number to the value given.
 */
 void setDirty(cache_t* cache, uint32_t blockNumber, uint8_t value) {
-	setBit(cache, numGarbageBits(cache) + 1 + blockNumber * totalBlockBits(cache), value);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		setFlag(cache, blockNumber, DIRTY_FLAG, value);
+		return;
+	}
+	setBit(cache, getDirtyLocation(cache, blockNumber), value);
 }
 
 /*
@@ -28,7 +51,11 @@ void setDirty(cache_t* cache, uint32_t blockNumber, uint8_t value) {
 	the shared bit at that block number to the value given.
 */
 void setShared(cache_t* cache, uint32_t blockNumber, uint8_t value) {
-	setBit(cache, numGarbageBits(cache) + 2 + blockNumber * totalBlockBits(cache), value);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		setFlag(cache, blockNumber, SHARED_FLAG, value);
+		return;
+	}
+	setBit(cache, getSharedLocation(cache, blockNumber), value);
 }
 
 /*
@@ -49,8 +76,12 @@ void setBit(cache_t* cache, uint64_t location, uint8_t value) {
 	that block number to the LRU value passed in.
 */
 void setLRU(cache_t* cache, uint32_t blockNumber, long newLRU) {
-	uint8_t LRUlen = numLRUBits(cache);
-	uint64_t location = numGarbageBits(cache) + blockNumber * totalBlockBits(cache) + (uint64_t)3;
+	uint8_t LRUlen = cache->geometry.LRUBits;
+	uint64_t location = getLRULocation(cache, blockNumber);
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		cache->store.LRU[blockNumber] = (uint32_t) (newLRU & ((UINT64_C(1) << LRUlen) - 1));
+		return;
+	}
 	for (uint8_t i = LRUlen; i > 0; i--) {
 		uint8_t bit = (newLRU >> (i - 1)) & (uint8_t) 1;
 		setBit(cache, location + LRUlen - i, bit);
@@ -71,9 +102,7 @@ void setData(cache_t* cache, uint8_t* data, uint32_t blockNumber, uint32_t lengt
 	uint64_t byteLoc = location >> 3;
 	int shiftAmount = location & 7;
 	if (shiftAmount == 0) {
-		for (uint32_t i = 0; i < length; i++) {
-			cache->contents[byteLoc + i] = data[i];
-		}
+		memcpy(cache->contents + byteLoc, data, length);
 	} else {
 		start = 0;
 		mask = 0;
@@ -114,8 +143,12 @@ void setTag(cache_t* cache, uint32_t tag, uint32_t blockNumber) {
 	uint64_t location = getTagLocation(cache, blockNumber);
 	uint64_t byteLoc = location >> 3;
 	uint8_t shiftAmount = location & 7;
-	uint8_t totalBits = getTagSize(cache);
+	uint8_t totalBits = cache->geometry.tagBits;
 	int start = 0;
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		cache->store.tags[blockNumber] = (uint32_t) (tag & ((UINT64_C(1) << totalBits) - 1));
+		return;
+	}
 	mask = 0;
 	if (totalBits + shiftAmount < 8) {
 		for (int i = shiftAmount; i < totalBits + shiftAmount; i++) {
@@ -164,13 +197,20 @@ void setTag(cache_t* cache, uint32_t tag, uint32_t blockNumber) {
 void clearCache(cache_t* cache) {
 	long newLRU = 0;
 	newLRU = ~newLRU;
-	uint32_t numBlocks = cache->totalDataSize / cache->blockDataSize;
+	uint32_t numBlocks = cache->geometry.numBlocks;
 	for (uint32_t i = 0; i < numBlocks; i++) {
 		setValid(cache, (uint32_t) i, 0);
 		setLRU(cache, (uint32_t) i, newLRU);
 	}
+	resetPolicyState(cache);
 	cache->access = 0;
 	cache->hit = 0;
+	cache->skipped = 0;
+	resetMissClassifier(cache->misses);
+	for (uint32_t i = 0; cache->setAccesses != NULL && i < cache->sampledSets; i++) {
+		cache->setAccesses[i] = 0;
+		cache->setHits[i] = 0;
+	}
 }
 
 /*
@@ -178,7 +218,7 @@ void clearCache(cache_t* cache) {
 	an dirty values to memory.
 */
 void contextSwitch(cache_t* cache) {
-	uint32_t numBlocks = getNumSets(cache) << (log_2(cache->n));
+	uint32_t numBlocks = cache->geometry.numBlocks;
 	for (int i = 0; i < numBlocks; i++) {
 		evict(cache, i);
 	}
@@ -190,7 +230,7 @@ void contextSwitch(cache_t* cache) {
 	values to be maximal.
 */
 void initializeLRU(cache_t* cache) {
-	for (int i = 0; i < getNumSets(cache) << log_2(cache->n); i++) {
+	for (int i = 0; i < cache->geometry.numBlocks; i++) {
 		setLRU(cache, i, cache->n - 1);
 	}
 }
@@ -203,8 +243,20 @@ void initializeLRU(cache_t* cache) {
 void updateLRU(cache_t* cache, uint32_t tag, uint32_t idx, long oldLRU) {
 	long currLRU;
 	uint32_t blockNumber;
-	uint32_t blockNumberStart = idx << log_2(cache->n);
-	//printf("Current LRU is %d and block # is %u\n", currLRU, blockNumber);
+	uint32_t blockNumberStart = idx << cache->geometry.waysBits;
+	if (cache->geometry.layout == FAST_LAYOUT) {
+		uint32_t* tags = cache->store.tags + blockNumberStart;
+		uint32_t* LRU = cache->store.LRU + blockNumberStart;
+		uint8_t* flags = cache->store.flags + blockNumberStart;
+		for (uint32_t i = 0; i < cache->n; i++) {
+			if (tags[i] == tag && (flags[i] & VALID_FLAG)) {
+				LRU[i] = 0;
+			} else if (LRU[i] < oldLRU) {
+				LRU[i]++;
+			}
+		}
+		return;
+	}
 	for (int i = 0; i < cache->n; i++) {
 		blockNumber = blockNumberStart + i;
 		if (tagEquals(blockNumber, tag, cache) && getValid(cache, blockNumber)) {
@@ -7,8 +7,11 @@
 #include <unistd.h>
 #include "utils.h"
 #include "getFromCache.h"
+#include "replacement.h"
 #include "setInCache.h"
 #include "cacheRead.h"
+#include "mem.h"
+#include "../part2/hitRate.h"
 
 /*
 	Used when memory cannot be allocated.
@@ -33,6 +36,14 @@ void physicalMemFailed() {
 	fprintf(stderr, "\nError: physical memory not found\n");
 }
 
+/*
+	Takes in the parameters of a cache and returns 1 if they describe a
+	valid cache and otherwise 0.
+*/
+static int validCacheParameters(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize) {
+	return oneBitOn(n) && oneBitOn(blockDataSize) && oneBitOn(totalDataSize) && blockDataSize <= totalDataSize && (totalDataSize / blockDataSize) >= n;
+}
+
 /*
 	Creates a new cache with N ways that has a block size of blockDataSize,
 	and a total data of size totalDataSize, both in Bytes. Also takes in a string
@@ -44,7 +55,7 @@ void physicalMemFailed() {
 
 cache_t* createCache(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize, char* physicalMemoryName) {
 	/* Your Code Here. */
-	if ( !oneBitOn(n) || !oneBitOn(blockDataSize) || !oneBitOn(totalDataSize) || blockDataSize > totalDataSize  || ((totalDataSize/blockDataSize) < n)) { // Invalid parameters
+	if (!validCacheParameters(n, blockDataSize, totalDataSize)) { // Invalid parameters
 		invalidCache();
 		return NULL;
 	}
@@ -53,7 +64,61 @@ cache_t* createCache(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize,
 		physicalMemFailed();
 		return NULL;
 	}
-	/* Your Code Here. */
+	physicalMemory_t* memory = openPhysicalMemory(physicalMemoryName);
+	if (memory == NULL) {
+		physicalMemFailed();
+		return NULL;
+	}
+	cache_t* newCache = createCacheFromMemory(n, blockDataSize, totalDataSize, memory);
+	releasePhysicalMemory(memory); // The cache holds its own reference
+	return newCache;
+}
+
+/*
+	Creates a new cache with N ways that has a block size of blockDataSize,
+	and a total data of size totalDataSize, both in Bytes, which uses an
+	already open memory as its main memory. The cache takes its own
+	reference to the memory. Returns a pointer to the cache. If any error
+	occurs call the appropriate error function and return NULL.
+*/
+cache_t* createCacheFromMemory(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize, physicalMemory_t* memory) {
+	return createCacheWithOptions(n, blockDataSize, totalDataSize, memory, NULL);
+}
+
+/*
+	Returns the options used by createCache and createCacheFromMemory.
+*/
+cacheOptions_t defaultCacheOptions() {
+	cacheOptions_t options;
+	options.layout = PACKED_LAYOUT;
+	options.policy = LRU_POLICY;
+	options.seed = 1;
+	options.sampleRatio = 1;
+	options.classifyMisses = false;
+	return options;
+}
+
+/*
+	Creates a new cache in the same way as createCacheFromMemory but with the
+	settings given in options. Passing NULL for options uses the defaults.
+	Returns a pointer to the cache. If any error occurs call the appropriate
+	error function and return NULL.
+*/
+cache_t* createCacheWithOptions(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize, physicalMemory_t* memory, cacheOptions_t* options) {
+	cacheOptions_t defaults = defaultCacheOptions();
+	if (options == NULL) {
+		options = &defaults;
+	}
+	if (!validCacheParameters(n, blockDataSize, totalDataSize) || !validPolicy(options->policy)
+		|| !oneBitOn(options->sampleRatio) || options->sampleRatio > totalDataSize / blockDataSize / n
+		|| (options->sampleRatio > 1 && options->policy == OPT_POLICY)) {
+		invalidCache();
+		return NULL;
+	}
+	if (memory == NULL) {
+		physicalMemFailed();
+		return NULL;
+	}
 	cache_t* newCache = (cache_t *) malloc(sizeof(cache_t));
 	if (newCache == NULL) {
 		allocationFailed();
@@ -62,21 +127,56 @@ cache_t* createCache(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize,
 
 	newCache->access = 0.0;
 	newCache->hit = 0.0;
+	newCache->skipped = 0.0;
 
-	newCache->physicalMemoryName = (char*) malloc((strlen(physicalMemoryName) + 1) * sizeof(char));
+	newCache->physicalMemoryName = (char*) malloc((strlen(memory->name) + 1) * sizeof(char));
 	if (newCache->physicalMemoryName == NULL) {
 		free(newCache);
 		allocationFailed();
 		return NULL;
 	}
 
-	strcpy(newCache->physicalMemoryName, physicalMemoryName); // Copying name to keep safe copy
+	strcpy(newCache->physicalMemoryName, memory->name); // Copying name to keep safe copy
+	newCache->memory = retainPhysicalMemory(memory);
 	newCache->n = n;
 	newCache->blockDataSize = blockDataSize;
 	newCache->totalDataSize = totalDataSize;
-
-	newCache->contents = (uint8_t *) malloc(cacheSizeBytes(newCache) * sizeof(uint8_t));
+	newCache->policy = options->policy;
+	newCache->engine = policyEngine(options->policy);
+	newCache->policySeed = options->seed;
+	newCache->nextUses = NULL;
+	newCache->uses = 0;
+	initializeGeometry(newCache, options->layout);
+	createPolicyState(newCache);
+	newCache->sampledSets = newCache->geometry.numSets;
+	newCache->currentSlot = 0;
+	newCache->setAccesses = NULL;
+	newCache->setHits = NULL;
+	if (options->sampleRatio > 1) {
+		newCache->sampledSets = newCache->geometry.numSets / options->sampleRatio;
+		newCache->setAccesses = (uint64_t *) calloc(newCache->sampledSets, sizeof(uint64_t));
+		newCache->setHits = (uint64_t *) calloc(newCache->sampledSets, sizeof(uint64_t));
+		if (newCache->setAccesses == NULL || newCache->setHits == NULL) {
+			allocationFailed();
+		}
+	}
+	newCache->misses = options->classifyMisses ? createMissClassifier(newCache) : NULL;
+
+	newCache->contents = (uint8_t *) malloc(newCache->geometry.allocBytes * sizeof(uint8_t));
+	newCache->store.tags = NULL;
+	newCache->store.LRU = NULL;
+	newCache->store.flags = NULL;
+	if (options->layout == FAST_LAYOUT) {
+		uint32_t numBlocks = newCache->geometry.numBlocks;
+		newCache->store.tags = (uint32_t *) calloc(numBlocks, sizeof(uint32_t));
+		newCache->store.LRU = (uint32_t *) calloc(numBlocks, sizeof(uint32_t));
+		newCache->store.flags = (uint8_t *) calloc(numBlocks, sizeof(uint8_t));
+		if (newCache->store.tags == NULL || newCache->store.LRU == NULL || newCache->store.flags == NULL) {
+			allocationFailed();
+		}
+	}
 	if (newCache->contents == NULL) {
+		releasePhysicalMemory(newCache->memory);
 		free(newCache->physicalMemoryName);
 		free(newCache);
 		allocationFailed();
@@ -86,14 +186,68 @@ cache_t* createCache(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize,
 	return newCache;
 }
 
+/*
+	Takes in a cache whose n, blockDataSize, totalDataSize, and policy have
+	been set and a layout and computes its geometry.
+*/
+void initializeGeometry(cache_t* cache, enum cacheLayout layout) {
+	cacheGeometry_t* geometry = &cache->geometry;
+	geometry->layout = layout;
+	geometry->offsetBits = log_2(cache->blockDataSize);
+	geometry->waysBits = log_2(cache->n);
+	geometry->indexBits = log_2(cache->totalDataSize) - geometry->offsetBits - geometry->waysBits;
+	geometry->tagBits = 32 - geometry->indexBits - geometry->offsetBits;
+	geometry->LRUBits = policyBlockBits(cache);
+	geometry->setStateBits = policySetBits(cache);
+	geometry->setStateBytes = policySetBytes(cache);
+	geometry->offsetMask = cache->blockDataSize - 1;
+	geometry->indexMask = (uint32_t) ((UINT64_C(1) << geometry->indexBits) - 1);
+	geometry->numSets = (cache->totalDataSize / cache->blockDataSize) / cache->n;
+	geometry->numBlocks = cache->totalDataSize / cache->blockDataSize;
+	geometry->validOffset = 0;
+	geometry->dirtyOffset = 1;
+	geometry->sharedOffset = 2;
+	geometry->LRUOffset = 3;
+	geometry->tagOffset = geometry->LRUOffset + geometry->LRUBits;
+	geometry->dataOffset = geometry->tagOffset + geometry->tagBits;
+	geometry->blockBits = geometry->dataOffset + ((uint64_t) 8 * cache->blockDataSize);
+	uint64_t blocksBits = geometry->numBlocks * geometry->blockBits;
+	geometry->sizeBits = blocksBits + (uint64_t) geometry->numSets * geometry->setStateBits + policyCacheBits(cache);
+	geometry->garbageBits = (uint8_t) ((8 - (geometry->sizeBits & 7)) & 7);
+	if (layout == FAST_LAYOUT) {
+		// Metadata lives in the tag store, contents is just the data rounded up to 8 bytes
+		geometry->dirtyOffset = 0;
+		geometry->sharedOffset = 0;
+		geometry->LRUOffset = 0;
+		geometry->tagOffset = 0;
+		geometry->dataOffset = 0;
+		geometry->strideBits = (((uint64_t) cache->blockDataSize + 7) & ~(uint64_t) 7) << 3;
+		geometry->firstBlockBit = 0;
+		geometry->allocBytes = (geometry->numBlocks * geometry->strideBits) >> 3;
+	} else {
+		geometry->strideBits = geometry->blockBits;
+		geometry->firstBlockBit = geometry->garbageBits;
+		// The policy state after the blocks is counted but kept in policyState
+		geometry->allocBytes = (geometry->sizeBits + geometry->garbageBits) >> 3;
+	}
+}
+
 /*
 	Function that frees all of the memory taken up by a cache.
 */
 void deleteCache(cache_t* cache) {
 	if (cache == NULL)
 		return;
+	releasePhysicalMemory(cache->memory);
 	free(cache->physicalMemoryName);
 	free(cache->contents);
+	free(cache->store.tags);
+	free(cache->store.LRU);
+	free(cache->store.flags);
+	free(cache->policyState);
+	free(cache->setAccesses);
+	free(cache->setHits);
+	deleteMissClassifier(cache->misses);
 	free(cache);
 	return;
 }
@@ -104,8 +258,7 @@ void deleteCache(cache_t* cache) {
 	0s.
 */
 uint32_t getTag(cache_t* cache, uint32_t address) {
-	uint8_t len = getTagSize(cache);
-	return address >> (32 - len);
+	return address >> (32 - cache->geometry.tagBits);
 }
 
 /*
@@ -114,15 +267,7 @@ uint32_t getTag(cache_t* cache, uint32_t address) {
 	0s.
 */
 uint32_t getIndex(cache_t* cache, uint32_t address) {
-	uint8_t indexLen = log_2(cache->totalDataSize) - log_2(cache->blockDataSize) - log_2(cache->n);
-	if (indexLen == 0)
-		return 0;
-	uint8_t tagLen = getTagSize(cache);
-	address = address << tagLen;
-	//printf("Address is %u\n", address);
-	uint32_t result = address >> (32 - indexLen);
-	//printf("Result is %u\n", result);
-	return result;
+	return (address >> cache->geometry.offsetBits) & cache->geometry.indexMask;
 }
 
 /*
@@ -131,27 +276,44 @@ uint32_t getIndex(cache_t* cache, uint32_t address) {
 	0s.
 */
 uint32_t getOffset(cache_t* cache, uint32_t address) {
-	/* Your Code Here. */
-	uint8_t offsetLen = log_2(cache->blockDataSize);
-	if (offsetLen == 0) {
-		return 0;
-	}
-	return (address << (32 - offsetLen)) >> (32 - offsetLen);
+	return address & cache->geometry.offsetMask;
 }
 
 /*
 	Returns for a cache the number sets the cache contains.
 */
 uint32_t getNumSets(cache_t* cache) {
-	return (cache->totalDataSize / cache->blockDataSize) / cache->n;
+	return cache->geometry.numSets;
+}
+
+/*
+	Takes in a cache and a set index and returns the slot of the set among
+	the sampled sets. The set is sampled if the slot is below sampledSets.
+	Slots are a permutation of the sets, so the sampled sets are spread
+	over the whole cache.
+*/
+uint32_t sampleSlot(cache_t* cache, uint32_t idx) {
+	return (idx * UINT32_C(2654435761)) & cache->geometry.indexMask;	// Odd multipliers permute the sets
+}
+
+/*
+	Takes in a cache and an address and returns whether the set of the
+	address is simulated, remembering its slot for the counts of the
+	access. Accesses to other sets should go straight to memory.
+*/
+bool sampleSet(cache_t* cache, uint32_t address) {
+	if (cache->setAccesses == NULL) {
+		return true;
+	}
+	cache->currentSlot = sampleSlot(cache, getIndex(cache, address));
+	return cache->currentSlot < cache->sampledSets;
 }
 
 /*
 	Given a cache returns the tag size in bits.
 */
 uint8_t getTagSize(cache_t* cache) {
-	uint8_t indexLen = log_2(cache->totalDataSize) - log_2(cache->blockDataSize) - log_2(cache->n);
-	return 32 - indexLen - log_2(cache->blockDataSize);
+	return cache->geometry.tagBits;
 }
 
 /*
@@ -159,23 +321,21 @@ uint8_t getTagSize(cache_t* cache) {
 	needs for each block.
 */
 uint8_t numLRUBits(cache_t* cache) {
-	return log_2(cache->n);
+	return cache->geometry.LRUBits;
 }
 
 /*
 	Returns the total size a block takes up for a cache.
 */
 uint64_t totalBlockBits(cache_t* cache) {
-	/* Your Code Here. */
-	return (uint64_t)3 + numLRUBits(cache) + ((uint64_t)8 * cache->blockDataSize) + getTagSize(cache);
+	return cache->geometry.blockBits;
 }
 
 /*
 	Takes in a cache and returns the space it occupies in bits.
 */
 uint64_t cacheSizeBits(cache_t* cache) {
-	/* Your Code Here. */
-	return (cache->totalDataSize / cache->blockDataSize) * totalBlockBits(cache);
+	return cache->geometry.sizeBits;
 }
 
 /*
@@ -193,10 +353,12 @@ uint64_t cacheSizeBytes(cache_t* cache) {
 	Calculates the number of garbage bits for the cache. Garbage Bits are
 	extra bits that have to be malloced because we are forced to malloc
 	a multiple of a byte. This will only be an issue for small caches but
-	should always be accounted for.
+	should always be accounted for. They round up the whole size from
+	cacheSizeBits, including the state of the replacement policy, so the
+	packed layout mallocs exactly cacheSizeBytes.
 */
 uint8_t numGarbageBits(cache_t* cache) {
-	return (uint8_t) ((8 - (cacheSizeBits(cache) & 7)) & 7);
+	return cache->geometry.garbageBits;
 }
 
 /*
@@ -204,8 +366,7 @@ uint8_t numGarbageBits(cache_t* cache) {
 	the block begins.
 */
 uint64_t getBlockStartBits(cache_t* cache, uint32_t blocknumber) {
-	/* Your Code Here. */
-	return numGarbageBits(cache) + (blocknumber * totalBlockBits(cache));
+	return cache->geometry.firstBlockBit + (blocknumber * cache->geometry.strideBits);
 }
 
 /*
@@ -247,7 +408,7 @@ void printCache(cache_t* cache) {
 	printf("----------------------------------------------------\n");
 	printf("set | valid | dirty | shared | LRU | tag | data\n");
 	for (uint64_t i = 0; i < sets * iterations; i++) {
-		printf("%ld | ", (i >> log_2(iterations)));
+		printf("%ld | ", (i >> cache->geometry.waysBits));
 		printf("%d | ", getValid(cache, i));
 		printf("%d | ", getDirty(cache, i));
 		printf("%d | ", getShared(cache, i));
@@ -286,13 +447,34 @@ uint8_t log_2(uint32_t val) {
 	return __builtin_ctz(val);
 }
 
+/*
+	Takes in a cache, an address, and a length and counts how many typed
+	accesses it takes to cover that range, always using the widest of
+	doubleword, word, halfword, and byte that is aligned, fits in what is
+	left, and is no wider than a block. This is the number of accesses the
+	range functions report.
+*/
+uint32_t countScalarAccesses(cache_t* cache, uint32_t address, uint32_t length) {
+	uint32_t widest = cache->blockDataSize < 8 ? cache->blockDataSize : 8;
+	uint32_t count = 0;
+	while (length > 0) {
+		uint32_t size = widest;
+		while (size > length || (address & (size - 1)) != 0) {
+			size >>= 1;
+		}
+		address += size;
+		length -= size;
+		count++;
+	}
+	return count;
+}
+
 /*
 	Takes in a cache and a block number and gets the location of the
 	of the valid bit in bits.
 */
 uint64_t getValidLocation(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBlockStartBits(cache, blockNumber);
+	return getBlockStartBits(cache, blockNumber) + cache->geometry.validOffset;
 }
 
 /*
@@ -300,8 +482,7 @@ uint64_t getValidLocation(cache_t* cache, uint32_t blockNumber) {
 	dirty bit in bits.
 */
 uint64_t getDirtyLocation(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBlockStartBits(cache, blockNumber) + 1;
+	return getBlockStartBits(cache, blockNumber) + cache->geometry.dirtyOffset;
 }
 
 /*
@@ -309,8 +490,7 @@ uint64_t getDirtyLocation(cache_t* cache, uint32_t blockNumber) {
 	shared bit in bits.
 */
 uint64_t getSharedLocation(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBlockStartBits(cache, blockNumber) + 2;
+	return getBlockStartBits(cache, blockNumber) + cache->geometry.sharedOffset;
 }
 
 /*
@@ -318,8 +498,7 @@ uint64_t getSharedLocation(cache_t* cache, uint32_t blockNumber) {
 	start of the LRU bits in bits.
 */
 uint64_t getLRULocation(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getBlockStartBits(cache, blockNumber) + 3;
+	return getBlockStartBits(cache, blockNumber) + cache->geometry.LRUOffset;
 }
 
 /*
@@ -327,8 +506,7 @@ uint64_t getLRULocation(cache_t* cache, uint32_t blockNumber) {
 	start of the tag bits in bits.
 */
 uint64_t getTagLocation(cache_t* cache, uint32_t blockNumber) {
-	/* Your Code Here. */
-	return getLRULocation(cache, blockNumber) + numLRUBits(cache);
+	return getBlockStartBits(cache, blockNumber) + cache->geometry.tagOffset;
 }
 
 /*
@@ -337,6 +515,5 @@ uint64_t getTagLocation(cache_t* cache, uint32_t blockNumber) {
 	for the start of data section at that offset in bits.
 */
 uint64_t getDataLocation(cache_t* cache, uint32_t blockNumber, uint32_t offset) {
-	/* Your Code Here. */
-	return getTagLocation(cache, blockNumber) + getTagSize(cache) + (8 * offset);
+	return getBlockStartBits(cache, blockNumber) + cache->geometry.dataOffset + ((uint64_t) 8 * offset);
 }
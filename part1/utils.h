@@ -2,13 +2,200 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+/*
+	Struct used to represent main memory. The backing file is loaded once
+	into image, a binary copy of the whole physical address range, so block
+	fills and write backs are plain memory copies. Text files keep the
+	physicalMemory*.txt format and are decoded on load and re-encoded on
+	flush, while files ending in .bin hold the raw bytes and are mapped
+	directly. The dirty fields are the byte range that still needs to be
+	written back to the file and fileBytes is the number of bytes the file
+	currently holds. Caches opened on the same file share one memory, which
+	is freed when its last reference is released. device and inode identify
+	the file, so every path that names it opens the same memory. A private
+	memory is a copy that is never shared or written back to its file.
+*/
+typedef struct physicalMemory
+{
+	char* name;
+	uint64_t device;
+	uint64_t inode;
+	uint8_t* image;
+	bool binary;
+	bool private;
+	uint32_t fileBytes;
+	uint32_t dirtyStart;
+	uint32_t dirtyEnd;
+	uint32_t references;
+	struct physicalMemory* next;
+} physicalMemory_t;
+
+/*
+	Enum used to select how the blocks of a cache are stored. The packed
+	layout stores every field of every block back to back in contents
+	exactly as the modeled hardware would. The fast layout keeps the tag,
+	flags and LRU of every block in the tag store and only the data in
+	contents, with every block starting on an 8 byte boundary, so lookups
+	scan plain arrays and block transfers are memory copies. Both layouts
+	report the same modeled size.
+*/
+enum cacheLayout {PACKED_LAYOUT, FAST_LAYOUT};
+
+/*
+	Enum used to select the replacement policy of a cache. LRU keeps a
+	log2(n) bit age for every block and rewrites the ages of the whole set
+	on every access. PLRU keeps a binary tree of n - 1 bits for every set
+	that points towards the pseudo least recently used way, so an access
+	or a victim search only visits log2(n) bits. The RRIP policies keep a
+	2 bit re-reference prediction for every block and evict a block
+	predicted to be reused furthest in the future. SRRIP inserts new blocks
+	with a long prediction and BRRIP mostly with a distant one, so a scan
+	cannot flush the blocks that are reused. DRRIP duels a few leader sets
+	of each and follows the one that misses less. FIFO evicts the block
+	filled longest ago, RANDOM a block chosen by a seeded generator, LFU the
+	block with the fewest hits, CLOCK the first block without its reference
+	bit set after a hand that sweeps the set, and NRU the first block that
+	has not been used since the whole set was last used. OPT is Belady's
+	offline policy, which evicts the block used again furthest in the
+	future. It needs the next use of every access from setNextUses, so it
+	can only replay a trace that was scanned beforehand, and it gives an
+	upper bound on the hit rate of any other policy.
+*/
+enum replacementPolicy {LRU_POLICY, PLRU_POLICY, SRRIP_POLICY, BRRIP_POLICY, DRRIP_POLICY,
+	FIFO_POLICY, RANDOM_POLICY, LFU_POLICY, CLOCK_POLICY, NRU_POLICY, OPT_POLICY};
+
+/*
+	Bits of the flags kept in the tag store for each block.
+*/
+#define VALID_FLAG 1
+#define DIRTY_FLAG 2
+#define SHARED_FLAG 4
+
+/*
+	Struct used to hold the metadata of a cache using the fast layout as a
+	structure of arrays. Each array has one entry per block, so the ways of
+	a set are contiguous and can be compared several at a time. All of the
+	arrays are NULL for the packed layout.
+*/
+typedef struct tagStore
+{
+	uint32_t* tags;
+	uint32_t* LRU;
+	uint8_t* flags;
+} tagStore_t;
+
+/*
+	Struct used to hold the layout of a cache. It is computed once when the
+	cache is created so that the accessors do not have to recompute logs and
+	sizes on every call. The bits fields are the widths of the address and
+	block fields, the masks select the index and offset of an address, and
+	the offset fields give the location of each field in bits from the start
+	of a block. blockBits and sizeBits are the modeled size of a block and
+	of the cache, which counts the per set and per cache state of the
+	replacement policy along with the blocks. garbageBits rounds sizeBits
+	up to a whole byte. strideBits is the distance between the start of two
+	blocks in contents, firstBlockBit is where block 0 begins and allocBytes
+	is how many bytes contents takes up. For the packed layout the stride
+	is the block size, block 0 begins after the garbage bits, and contents
+	takes up the whole size, so allocBytes is cacheSizeBytes. For the fast
+	layout contents only holds data, so every field offset is 0 and the
+	metadata locations do not refer to contents. LRUBits is the width of
+	the per block state of the replacement policy, which is kept in the LRU
+	field, and setStateBits and setStateBytes are the modeled size and the
+	stored size of its per set state.
+*/
+typedef struct cacheGeometry
+{
+	enum cacheLayout layout;
+	uint8_t offsetBits;
+	uint8_t indexBits;
+	uint8_t tagBits;
+	uint8_t waysBits;
+	uint8_t LRUBits;
+	uint8_t garbageBits;
+	uint32_t offsetMask;
+	uint32_t indexMask;
+	uint32_t numSets;
+	uint32_t numBlocks;
+	uint32_t setStateBits;
+	uint32_t setStateBytes;
+	uint64_t blockBits;
+	uint64_t strideBits;
+	uint64_t firstBlockBit;
+	uint64_t validOffset;
+	uint64_t dirtyOffset;
+	uint64_t sharedOffset;
+	uint64_t LRUOffset;
+	uint64_t tagOffset;
+	uint64_t dataOffset;
+	uint64_t sizeBits;
+	uint64_t allocBytes;
+} cacheGeometry_t;
+
+/*
+	Struct used to pass optional settings to createCacheWithOptions. Use
+	defaultCacheOptions to get the settings createCache uses and change only
+	the fields that are needed. With a sampleRatio above 1 only one set in
+	every sampleRatio is simulated and accesses to the other sets go
+	straight to memory without being looked up. OPT cannot be sampled, since
+	its next uses count every access. classifyMisses makes the cache sort
+	its misses into compulsory, capacity, and conflict misses.
+*/
+typedef struct cacheOptions
+{
+	enum cacheLayout layout;
+	enum replacementPolicy policy;
+	uint32_t seed;
+	uint32_t sampleRatio;
+	bool classifyMisses;
+} cacheOptions_t;
+
+/*
+	Struct used to sort the misses of a cache into the three Cs. touched
+	holds one bit for every block of memory, set once the block has been
+	accessed. The other fields model a fully associative LRU cache of the
+	same number of blocks as a list of blocks from head, the most recently
+	used, to tail, linked through previous and next, which are indexed by
+	block of memory. resident holds one bit for every block in the list,
+	size is the number of them, and blocks the most the list holds out of
+	the memoryBlocks blocks of memory. A miss to a block never touched is
+	compulsory, a miss that also misses in the list is a capacity miss,
+	and the rest are conflict misses.
+*/
+typedef struct missClassifier
+{
+	uint8_t* touched;
+	uint8_t* resident;
+	uint32_t* previous;
+	uint32_t* next;
+	uint32_t head;
+	uint32_t tail;
+	uint32_t size;
+	uint32_t blocks;
+	uint32_t memoryBlocks;
+	double compulsory;
+	double capacity;
+	double conflict;
+} missClassifier_t;
+
 /*
 	Struct to be used to represent a cache. Both the block data size
 	and the total data size is given in bytes. The physical Memory Name
 	is the name of the file which will function as main memory for the
 	cache. The access and hit fields are used to track cache accesses
 	and are used for hit rate. This will be implemented in part 2 of
-	the project.
+	the project. The memory field points to the loaded contents of the
+	physical memory file, the geometry holds the precomputed layout, and the
+	store holds the metadata of the fast layout. engine implements the
+	replacement policy, policyState holds its per set state, setStateBytes
+	bytes for each set, and the fields after it its state for the whole
+	cache. nextUses holds the next use of each of the uses accesses OPT
+	will see and usePosition is the next one to be seen. sampledSets is the
+	number of sets simulated, and when it is below the number of sets
+	setAccesses and setHits count the accesses and hits of each of them,
+	indexed by sampleSlot, skipped counts the accesses sent to memory, and
+	currentSlot is the slot of the access being made. misses classifies the
+	misses of the cache, or is NULL if they are not classified.
 */
 typedef struct cache
 {
@@ -17,8 +204,27 @@ typedef struct cache
 	uint32_t totalDataSize;
 	uint8_t* contents;
 	char* physicalMemoryName;
+	physicalMemory_t* memory;
+	cacheGeometry_t geometry;
+	tagStore_t store;
+	enum replacementPolicy policy;
+	const struct replacementEngine* engine;
+	uint8_t* policyState;
+	uint32_t policySelector;
+	uint32_t policyFills;
+	uint32_t policySeed;
+	uint32_t policyRandom;
+	uint32_t* nextUses;
+	uint64_t uses;
+	uint64_t usePosition;
 	double access;
 	double hit;
+	uint32_t sampledSets;
+	uint32_t currentSlot;
+	uint64_t* setAccesses;
+	uint64_t* setHits;
+	double skipped;
+	missClassifier_t* misses;
 } cache_t;
 
 /*
@@ -33,6 +239,35 @@ typedef struct eviction
 	bool match;	
 }evictionInfo_t;
 
+/*
+	Struct used to implement a replacement policy. The sizing functions give
+	the modeled bits of state the policy keeps for every block, which are
+	stored in the LRU field, for every set, and for the whole cache, and the
+	bytes policyState stores for every set. reset is called when the cache
+	is cleared. victim picks the block to evict for an address that missed
+	and may only read the state, since lookups that never fill also search
+	for victims. hit and fill are called after an access hits or fills a
+	block and invalidate after a block is invalidated by another cache.
+	repeatedHits is set when hit must also see the accesses that hit the
+	block of the previous access without a lookup. A NULL sizing function
+	means no state, a NULL victim keeps the block with the highest LRU
+	field found by the set scan, and a NULL hook does nothing.
+*/
+typedef struct replacementEngine
+{
+	char* name;
+	uint8_t (*blockBits)(cache_t* cache);
+	uint32_t (*setBits)(cache_t* cache);
+	uint32_t (*setBytes)(cache_t* cache);
+	uint32_t cacheBits;
+	void (*reset)(cache_t* cache);
+	void (*victim)(cache_t* cache, uint32_t firstBlock, evictionInfo_t* info);
+	void (*hit)(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info);
+	void (*fill)(cache_t* cache, uint32_t tag, uint32_t idx, evictionInfo_t* info);
+	void (*invalidate)(cache_t* cache, uint32_t blockNumber);
+	bool repeatedHits;
+} replacementEngine_t;
+
 /*
 	A struct used to returns a byte cache read. It returns both
 	the data present in the cache and a bool flag which displays whether
@@ -77,6 +312,36 @@ typedef struct doubleWordInfo
 	uint64_t data;
 } doubleWordInfo_t;
 
+/*
+	Enum used to say whether a batched access reads or writes.
+*/
+enum accessType {READ_ACCESS, WRITE_ACCESS};
+
+/*
+	A struct used to describe one access of a batch. The size is in bytes
+	and must be 1, 2, 4, or 8. For writes data holds the value to write,
+	stored the same way as the argument of the typed write of that size.
+*/
+typedef struct cacheRequest
+{
+	enum accessType op;
+	uint32_t address;
+	uint32_t size;
+	uint64_t data;
+} cacheRequest_t;
+
+/*
+	A struct used to return the result of one access of a batch. It holds
+	whether the access was valid and performed, whether it hit in the
+	cache, and for reads the data read.
+*/
+typedef struct cacheResult
+{
+	bool success;
+	bool hit;
+	uint64_t data;
+} cacheResult_t;
+
 /*
 	Used when memory cannot be allocated.
 */
@@ -103,6 +368,34 @@ void physicalMemFailed();
 */ 
 cache_t* createCache(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize, char* physicalMemoryName);
 
+/*
+	Creates a new cache with N ways that has a block size of blockDataSize,
+	and a total data of size totalDataSize, both in Bytes, which uses an
+	already open memory as its main memory. The cache takes its own
+	reference to the memory. Returns a pointer to the cache. If any error
+	occurs call the appropriate error function and return NULL.
+*/
+cache_t* createCacheFromMemory(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize, physicalMemory_t* memory);
+
+/*
+	Returns the options used by createCache and createCacheFromMemory.
+*/
+cacheOptions_t defaultCacheOptions();
+
+/*
+	Creates a new cache in the same way as createCacheFromMemory but with the
+	settings given in options. Passing NULL for options uses the defaults.
+	Returns a pointer to the cache. If any error occurs call the appropriate
+	error function and return NULL.
+*/
+cache_t* createCacheWithOptions(uint32_t n, uint32_t blockDataSize, uint32_t totalDataSize, physicalMemory_t* memory, cacheOptions_t* options);
+
+/*
+	Takes in a cache whose n, blockDataSize, totalDataSize, and policy have
+	been set and a layout and computes its geometry.
+*/
+void initializeGeometry(cache_t* cache, enum cacheLayout layout);
+
 /*
 	Function that frees all of the memory taken up by a cache.
 */
@@ -134,6 +427,21 @@ uint32_t getOffset(cache_t* cache, uint32_t address);
 */
 uint32_t getNumSets(cache_t* cache);
 
+/*
+	Takes in a cache and a set index and returns the slot of the set among
+	the sampled sets. The set is sampled if the slot is below sampledSets.
+	Slots are a permutation of the sets, so the sampled sets are spread
+	over the whole cache.
+*/
+uint32_t sampleSlot(cache_t* cache, uint32_t idx);
+
+/*
+	Takes in a cache and an address and returns whether the set of the
+	address is simulated, remembering its slot for the counts of the
+	access. Accesses to other sets should go straight to memory.
+*/
+bool sampleSet(cache_t* cache, uint32_t address);
+
 /*
 	Given a cache returns the tag size in bits.
 */
@@ -159,7 +467,9 @@ uint64_t cacheSizeBytes(cache_t* cache);
 	Calculates the number of garbage bits for the cache. Garbage Bits are
 	extra bits that have to be malloced because we are forced to malloc
 	a multiple of a byte. This will only be an issue for small caches but
-	should always be accounted for.
+	should always be accounted for. They round up the whole size from
+	cacheSizeBits, including the state of the replacement policy, so the
+	packed layout mallocs exactly cacheSizeBytes.
 */
 uint8_t numGarbageBits(cache_t* cache);
 
@@ -213,6 +523,15 @@ int oneBitOn(uint32_t val);
 */
 uint8_t log_2(uint32_t val);
 
+/*
+	Takes in a cache, an address, and a length and counts how many typed
+	accesses it takes to cover that range, always using the widest of
+	doubleword, word, halfword, and byte that is aligned, fits in what is
+	left, and is no wider than a block. This is the number of accesses the
+	range functions report.
+*/
+uint32_t countScalarAccesses(cache_t* cache, uint32_t address, uint32_t length);
+
 /*
 	Takes in a cache and a block number and gets the location of the 
 	of the valid bit in bits.
@@ -1,7 +1,10 @@
 /* Summer 2017 */
 #include <stdbool.h>
 #include <stdint.h>
+#include <math.h>
+#include <string.h>
 #include "../part1/utils.h"
+#include "../part1/mem.h"
 #include "hitRate.h"
 
 /*
@@ -12,11 +15,158 @@ double findHitRate(cache_t* cache) {
 	return cache->hit / cache->access;
 }
 
+/*
+	Function used to return the half width of the 95% confidence interval
+	of the hit rate of a cache that simulates only a sample of its sets.
+	The sampled sets are treated as a random sample of clusters of
+	accesses, so the estimate accounts for sets that hit more than others.
+	Returns 0 if every set is simulated and -1 if fewer than 2 sets are
+	sampled or nothing has been accessed.
+*/
+double hitRateMargin(cache_t* cache) {
+	uint32_t sets = cache->sampledSets;
+	if (cache->setAccesses == NULL) {
+		return 0;
+	}
+	if (sets < 2 || cache->access == 0) {
+		return -1;
+	}
+	double rate = cache->hit / cache->access;
+	double mean = cache->access / sets;
+	double squares = 0;
+	for (uint32_t i = 0; i < sets; i++) {
+		double residual = cache->setHits[i] - rate * cache->setAccesses[i];
+		squares += residual * residual;
+	}
+	double fraction = (double) sets / getNumSets(cache);
+	double variance = (1 - fraction) * squares / (sets - 1) / (sets * mean * mean);
+	return 1.96 * sqrt(variance);
+}
+
+/*
+	Function used to create the miss classifier of a cache whose geometry
+	and sampled sets are set. The modeled fully associative cache holds as
+	many blocks as the sets that are simulated.
+*/
+missClassifier_t* createMissClassifier(cache_t* cache) {
+	missClassifier_t* misses = malloc(sizeof(missClassifier_t));
+	if (misses == NULL) {
+		allocationFailed();
+	}
+	uint32_t memoryBlocks = MEMORY_SIZE / cache->blockDataSize;
+	misses->blocks = cache->sampledSets * cache->n;
+	misses->memoryBlocks = memoryBlocks;
+	misses->touched = malloc((memoryBlocks + 7) / 8);
+	misses->resident = malloc((memoryBlocks + 7) / 8);
+	misses->previous = malloc(sizeof(uint32_t) * memoryBlocks);
+	misses->next = malloc(sizeof(uint32_t) * memoryBlocks);
+	if (misses->touched == NULL || misses->resident == NULL || misses->previous == NULL || misses->next == NULL) {
+		allocationFailed();
+	}
+	resetMissClassifier(misses);
+	return misses;
+}
+
+/*
+	Function used to forget every block a miss classifier has seen and
+	zero its counts, as when its cache is cleared. Does nothing for NULL.
+*/
+void resetMissClassifier(missClassifier_t* misses) {
+	if (misses == NULL) {
+		return;
+	}
+	memset(misses->touched, 0, (misses->memoryBlocks + 7) / 8);
+	memset(misses->resident, 0, (misses->memoryBlocks + 7) / 8);
+	misses->size = 0;
+	misses->compulsory = 0;
+	misses->capacity = 0;
+	misses->conflict = 0;
+}
+
+/*
+	Function used to free a miss classifier. Does nothing for NULL.
+*/
+void deleteMissClassifier(missClassifier_t* misses) {
+	if (misses == NULL) {
+		return;
+	}
+	free(misses->touched);
+	free(misses->resident);
+	free(misses->previous);
+	free(misses->next);
+	free(misses);
+}
+
+/*
+	Takes in a miss classifier and a block of memory in its list and
+	removes the block from the list.
+*/
+static void unlinkBlock(missClassifier_t* misses, uint32_t block) {
+	if (block == misses->head) {
+		misses->head = misses->next[block];
+	} else {
+		misses->next[misses->previous[block]] = misses->next[block];
+	}
+	if (block == misses->tail) {
+		misses->tail = misses->previous[block];
+	} else {
+		misses->previous[misses->next[block]] = misses->previous[block];
+	}
+	misses->resident[block >> 3] &= ~(1 << (block & 7));
+	misses->size--;
+}
+
+/*
+	Function used to update the miss classifier of a cache, if it has one,
+	with an access to an address that hit or missed in the cache. Misses
+	are classified before the modeled fully associative cache sees the
+	access, and every access moves its block to the front of the model.
+*/
+void classifyAccess(cache_t* cache, uint32_t address, bool hit) {
+	missClassifier_t* misses = cache->misses;
+	if (misses == NULL) {
+		return;
+	}
+	uint32_t block = (address - MIN_ADDRESS) >> cache->geometry.offsetBits;
+	uint8_t bit = 1 << (block & 7);
+	bool resident = misses->resident[block >> 3] & bit;
+	if (!hit) {
+		if (!(misses->touched[block >> 3] & bit)) {
+			misses->touched[block >> 3] |= bit;
+			misses->compulsory++;
+		} else if (!resident) {
+			misses->capacity++;
+		} else {
+			misses->conflict++;
+		}
+	}
+	if (resident) {
+		if (block == misses->head) {
+			return;
+		}
+		unlinkBlock(misses, block);
+	} else if (misses->size == misses->blocks) {
+		unlinkBlock(misses, misses->tail);
+	}
+	if (misses->size == 0) {
+		misses->tail = block;
+	} else {
+		misses->previous[misses->head] = block;
+	}
+	misses->next[block] = misses->head;
+	misses->head = block;
+	misses->resident[block >> 3] |= bit;
+	misses->size++;
+}
+
 /*
 	Function used to update the cache indicating there has been a cache access.
 */
 void reportAccess(cache_t* cache) {
 	cache->access++;
+	if (cache->setAccesses != NULL) {
+		cache->setAccesses[cache->currentSlot]++;
+	}
 }
 
 /*
@@ -24,4 +174,7 @@ void reportAccess(cache_t* cache) {
 */
 void reportHit(cache_t* cache) {
 	cache->hit++;
+	if (cache->setHits != NULL) {
+		cache->setHits[cache->currentSlot]++;
+	}
 }
@@ -8,6 +8,40 @@
 */
 double findHitRate(cache_t* cache);
 
+/*
+	Function used to return the half width of the 95% confidence interval
+	of the hit rate of a cache that simulates only a sample of its sets.
+	Returns 0 if every set is simulated and -1 if fewer than 2 sets are
+	sampled or nothing has been accessed.
+*/
+double hitRateMargin(cache_t* cache);
+
+/*
+	Function used to create the miss classifier of a cache whose geometry
+	and sampled sets are set. The modeled fully associative cache holds as
+	many blocks as the sets that are simulated.
+*/
+missClassifier_t* createMissClassifier(cache_t* cache);
+
+/*
+	Function used to forget every block a miss classifier has seen and
+	zero its counts, as when its cache is cleared. Does nothing for NULL.
+*/
+void resetMissClassifier(missClassifier_t* misses);
+
+/*
+	Function used to free a miss classifier. Does nothing for NULL.
+*/
+void deleteMissClassifier(missClassifier_t* misses);
+
+/*
+	Function used to update the miss classifier of a cache, if it has one,
+	with an access to an address that hit or missed in the cache. Misses
+	are classified before the modeled fully associative cache sees the
+	access, and every access moves its block to the front of the model.
+*/
+void classifyAccess(cache_t* cache, uint32_t address, bool hit);
+
 /*
 	Function used to update the cache indicating there has been a cache access.
 */
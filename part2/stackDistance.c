@@ -0,0 +1,283 @@
+/* Summer 2017 */
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "../part1/cacheBatch.h"
+#include "../part3/coherenceUtils.h"
+#include "stackDistance.h"
+
+/*
+	Takes in a Fenwick tree of size positions, a position starting at 1,
+	and an amount and adds the amount at the position.
+*/
+static void treeAdd(uint32_t* tree, uint32_t size, uint32_t position, int32_t amount) {
+	for (; position <= size; position += position & -position) {
+		tree[position - 1] += amount;
+	}
+}
+
+/*
+	Takes in a Fenwick tree and a position and returns the sum of the
+	positions up to and including it.
+*/
+static uint32_t treeSum(uint32_t* tree, uint32_t position) {
+	uint32_t sum = 0;
+	for (; position > 0; position -= position & -position) {
+		sum += tree[position - 1];
+	}
+	return sum;
+}
+
+/*
+	Takes in a mapping and a set and rebuilds the tree of the set from its
+	timeline in linear time, setting every position that holds the last
+	access to its block.
+*/
+static void buildTree(setMapping_t* mapping, uint32_t set) {
+	uint32_t* tree = mapping->tree + (uint64_t) set * mapping->capacity;
+	uint32_t* blocks = mapping->blocks + (uint64_t) set * mapping->capacity;
+	memset(tree, 0, sizeof(uint32_t) * mapping->capacity);
+	for (uint32_t position = 1; position <= mapping->capacity; position++) {
+		tree[position - 1] += position <= mapping->times[set] && mapping->last[blocks[position - 1]] == position;
+		uint32_t parent = position + (position & -position);
+		if (parent <= mapping->capacity) {
+			tree[parent - 1] += tree[position - 1];
+		}
+	}
+}
+
+/*
+	Takes in a mapping and a set whose timeline is full and moves the last
+	access to every block of the set to the front of the timeline, in the
+	same order, then rebuilds the tree of the set. The timeline holds at
+	least twice as many positions as the set has blocks, so this happens
+	at most once every capacity / 2 accesses to the set.
+*/
+static void compactSet(setMapping_t* mapping, uint32_t set) {
+	uint32_t* blocks = mapping->blocks + (uint64_t) set * mapping->capacity;
+	uint32_t live = 0;
+	for (uint32_t position = 1; position <= mapping->times[set]; position++) {
+		uint32_t block = blocks[position - 1];
+		if (mapping->last[block] == position) {
+			blocks[live++] = block;
+			mapping->last[block] = live;
+		}
+	}
+	mapping->times[set] = live;
+	buildTree(mapping, set);
+}
+
+/*
+	Takes in a mapping and doubles the timeline of every set, keeping the
+	positions of every access. Used when more sampled blocks map to a set
+	than it was sized for.
+*/
+static void growMapping(setMapping_t* mapping) {
+	uint32_t numSets = 1 << mapping->setBits;
+	uint32_t capacity = mapping->capacity * 2;
+	uint32_t* blocks = malloc(sizeof(uint32_t) * (uint64_t) numSets * capacity);
+	uint32_t* tree = malloc(sizeof(uint32_t) * (uint64_t) numSets * capacity);
+	if (blocks == NULL || tree == NULL) {
+		allocationFailed();
+	}
+	for (uint32_t set = 0; set < numSets; set++) {
+		memcpy(blocks + (uint64_t) set * capacity, mapping->blocks + (uint64_t) set * mapping->capacity,
+			sizeof(uint32_t) * mapping->times[set]);
+	}
+	free(mapping->blocks);
+	free(mapping->tree);
+	mapping->blocks = blocks;
+	mapping->tree = tree;
+	mapping->capacity = capacity;
+	for (uint32_t set = 0; set < numSets; set++) {
+		buildTree(mapping, set);
+	}
+}
+
+/*
+	Takes in a mapping, the number of a block of memory, and the sampling
+	threshold of the tracker and records an access to the block in its
+	set.
+*/
+static void recordMapping(setMapping_t* mapping, uint32_t block, uint32_t threshold) {
+	uint32_t set = block & ((1 << mapping->setBits) - 1);
+	if (mapping->times[set] == mapping->capacity) {
+		compactSet(mapping, set);
+		if (mapping->times[set] * 2 > mapping->capacity) {
+			growMapping(mapping);
+		}
+	}
+	uint32_t* tree = mapping->tree + (uint64_t) set * mapping->capacity;
+	uint32_t position = ++mapping->times[set];
+	uint32_t previous = mapping->last[block];
+	uint32_t distance = mapping->maxWays;
+	if (previous != 0) {
+		uint64_t between = treeSum(tree, position - 1) - treeSum(tree, previous);
+		between = between * SAMPLE_MODULUS / threshold;		// Each sampled block stands for 1 / rate blocks
+		distance = between < mapping->maxWays ? between : mapping->maxWays;
+		treeAdd(tree, mapping->capacity, previous, -1);
+	}
+	mapping->distances[distance]++;
+	treeAdd(tree, mapping->capacity, position, 1);
+	mapping->blocks[(uint64_t) set * mapping->capacity + position - 1] = block;
+	mapping->last[block] = position;
+}
+
+/*
+	Takes in a value and returns whether it is a power of 2.
+*/
+static bool powerOfTwo(uint32_t value) {
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+/*
+	Takes in a block size and the largest total data size of interest and
+	creates the stack distance tracker for them. Each recorded access costs
+	O(log n) for every number of sets, and the tracker uses about 20 bytes
+	per block of memory for every number of sets. Returns NULL if the block
+	size is not a power of 2 or the total size is not a power of 2 between
+	the block size and the size of memory.
+*/
+stackDistance_t* createStackDistance(uint32_t blockDataSize, uint32_t maxDataSize) {
+	return createSampledStackDistance(blockDataSize, maxDataSize, 1);
+}
+
+/*
+	Takes in a block size, the largest total data size of interest, and a
+	sampling rate above 0 and at most 1 and creates a tracker in the same
+	way as createStackDistance that only tracks that fraction of the
+	blocks, picked by hashing their addresses. The hit rates it gives are
+	estimates, and its timelines and its time per access shrink with the
+	rate. Returns NULL if the parameters are not valid.
+*/
+stackDistance_t* createSampledStackDistance(uint32_t blockDataSize, uint32_t maxDataSize, double rate) {
+	if (!powerOfTwo(blockDataSize) || !powerOfTwo(maxDataSize) || maxDataSize < blockDataSize
+		|| maxDataSize > MEMORY_SIZE || !(rate > 0 && rate <= 1)) {
+		return NULL;
+	}
+	stackDistance_t* tracker = malloc(sizeof(stackDistance_t));
+	if (tracker == NULL) {
+		allocationFailed();
+		return NULL;
+	}
+	uint32_t memoryBlocks = MEMORY_SIZE / blockDataSize;
+	uint32_t maxBlocks = maxDataSize / blockDataSize;
+	tracker->blockDataSize = blockDataSize;
+	tracker->maxDataSize = maxDataSize;
+	tracker->numMappings = log_2(maxBlocks) + 1;
+	tracker->accesses = 0;
+	tracker->sampled = 0;
+	tracker->sampleThreshold = (uint32_t) (rate * SAMPLE_MODULUS);
+	if (tracker->sampleThreshold == 0) {
+		tracker->sampleThreshold = 1;
+	}
+	tracker->mappings = malloc(sizeof(setMapping_t) * tracker->numMappings);
+	if (tracker->mappings == NULL) {
+		allocationFailed();
+	}
+	for (uint32_t i = 0; i < tracker->numMappings; i++) {
+		setMapping_t* mapping = &tracker->mappings[i];
+		uint32_t numSets = 1 << i;
+		mapping->setBits = i;
+		uint64_t expected = (uint64_t) (memoryBlocks / numSets) * tracker->sampleThreshold / SAMPLE_MODULUS;
+		mapping->capacity = 2 * (expected > 0 ? expected : 1);
+		mapping->maxWays = maxBlocks / numSets;
+		mapping->tree = calloc((uint64_t) numSets * mapping->capacity, sizeof(uint32_t));
+		mapping->blocks = malloc(sizeof(uint32_t) * (uint64_t) numSets * mapping->capacity);
+		mapping->times = calloc(numSets, sizeof(uint32_t));
+		mapping->last = calloc(memoryBlocks, sizeof(uint32_t));
+		mapping->distances = calloc(mapping->maxWays + 1, sizeof(uint64_t));
+		if (mapping->tree == NULL || mapping->blocks == NULL || mapping->times == NULL
+			|| mapping->last == NULL || mapping->distances == NULL) {
+			allocationFailed();
+		}
+	}
+	return tracker;
+}
+
+/*
+	Takes in a stack distance tracker and frees everything it uses.
+*/
+void deleteStackDistance(stackDistance_t* tracker) {
+	if (tracker == NULL) {
+		return;
+	}
+	for (uint32_t i = 0; i < tracker->numMappings; i++) {
+		free(tracker->mappings[i].tree);
+		free(tracker->mappings[i].blocks);
+		free(tracker->mappings[i].times);
+		free(tracker->mappings[i].last);
+		free(tracker->mappings[i].distances);
+	}
+	free(tracker->mappings);
+	free(tracker);
+}
+
+/*
+	Takes in a stack distance tracker and a valid address and records one
+	access to the block holding the address.
+*/
+void recordAccess(stackDistance_t* tracker, uint32_t address) {
+	uint32_t block = (address - MIN_ADDRESS) / tracker->blockDataSize;
+	tracker->accesses++;
+	if (tracker->sampleThreshold < SAMPLE_MODULUS
+		&& (hash(address & ~(tracker->blockDataSize - 1)) & (SAMPLE_MODULUS - 1)) >= tracker->sampleThreshold) {
+		return;
+	}
+	for (uint32_t i = 0; i < tracker->numMappings; i++) {
+		recordMapping(&tracker->mappings[i], block, tracker->sampleThreshold);
+	}
+	tracker->sampled++;
+}
+
+/*
+	Takes in a stack distance tracker, an array of requests, and the number
+	of requests and records the accesses accessBatch would make for them.
+	Invalid requests are skipped and a request wider than a block is one
+	access to every block it covers.
+*/
+void recordRequests(stackDistance_t* tracker, cacheRequest_t* requests, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		if (!validRequest(&requests[i])) {
+			continue;
+		}
+		uint32_t blocks = requests[i].size > tracker->blockDataSize ? requests[i].size / tracker->blockDataSize : 1;
+		for (uint32_t j = 0; j < blocks; j++) {
+			recordAccess(tracker, requests[i].address + j * tracker->blockDataSize);
+		}
+	}
+}
+
+/*
+	Takes in a stack distance tracker, an associativity, and a total data
+	size and returns the hit rate an LRU cache with those parameters and
+	the tracker's block size would have had over the recorded accesses.
+	Returns -1 if the tracker does not cover the cache.
+*/
+double stackHitRate(stackDistance_t* tracker, uint32_t n, uint32_t totalDataSize) {
+	if (!powerOfTwo(n) || !powerOfTwo(totalDataSize) || totalDataSize > tracker->maxDataSize
+		|| (uint64_t) n * tracker->blockDataSize > totalDataSize) {
+		return -1;
+	}
+	uint32_t numSets = totalDataSize / tracker->blockDataSize / n;
+	setMapping_t* mapping = &tracker->mappings[log_2(numSets)];
+	uint64_t hits = 0;
+	for (uint32_t distance = 0; distance < n; distance++) {
+		hits += mapping->distances[distance];
+	}
+	if (tracker->sampleThreshold == SAMPLE_MODULUS) {
+		return tracker->accesses > 0 ? (double) hits / tracker->accesses : 0;
+	}
+	// A few hot blocks decide how many accesses are sampled, so the accesses
+	// missing from or beyond the expected sample are counted as the hits to
+	// the hottest blocks they most likely are
+	double expected = (double) tracker->accesses * tracker->sampleThreshold / SAMPLE_MODULUS;
+	if (expected <= 0) {
+		return 0;
+	}
+	double rate = (hits + expected - tracker->sampled) / expected;
+	return rate < 0 ? 0 : rate > 1 ? 1 : rate;
+}
@@ -0,0 +1,107 @@
+/* Summer 2017 */
+#ifndef STACKDISTANCE_H
+#define STACKDISTANCE_H
+
+/*
+	A sampled tracker keeps the blocks whose hash modulo SAMPLE_MODULUS is
+	below its threshold, so a threshold of SAMPLE_MODULUS keeps every block.
+*/
+#define SAMPLE_MODULUS (1 << 16)
+
+/*
+	Struct used to track the LRU stack distances of a trace for caches with
+	2^setBits sets. Each set has its own timeline of capacity positions in
+	tree, a Fenwick tree holding 1 at the position of the last access to
+	every block, so the stack distance of an access is the number of
+	positions set after the last access to its block. blocks holds the
+	block accessed at every position, times the last position used in every
+	set, and last the position of the last access to every block of
+	memory, or 0 if it has not been accessed. distances counts the accesses
+	at every distance below maxWays, and entry maxWays counts the ones at
+	least that far, including first accesses. The timeline of every set
+	starts with room for twice the blocks expected to map to it and
+	doubles if a set ever needs more.
+*/
+typedef struct setMapping
+{
+	uint32_t setBits;
+	uint32_t capacity;
+	uint32_t maxWays;
+	uint32_t* tree;
+	uint32_t* blocks;
+	uint32_t* times;
+	uint32_t* last;
+	uint64_t* distances;
+} setMapping_t;
+
+/*
+	Struct used to find the hit rates of every LRU cache with a block size
+	of blockDataSize and at most maxDataSize bytes of data in a single pass
+	over a trace. There is a mapping for every number of sets from 1 to
+	maxDataSize / blockDataSize. accesses counts the accesses recorded.
+	Only the blocks picked by sampleThreshold are tracked, sampled counts
+	their accesses, and their distances are scaled up by the inverse of
+	the sampling rate, so the hit rates estimate those of every block.
+*/
+typedef struct stackDistance
+{
+	uint32_t blockDataSize;
+	uint32_t maxDataSize;
+	uint32_t numMappings;
+	setMapping_t* mappings;
+	uint64_t accesses;
+	uint32_t sampleThreshold;
+	uint64_t sampled;
+} stackDistance_t;
+
+/*
+	Takes in a block size and the largest total data size of interest and
+	creates the stack distance tracker for them. Each recorded access costs
+	O(log n) for every number of sets, and the tracker uses about 20 bytes
+	per block of memory for every number of sets. Returns NULL if the block
+	size is not a power of 2 or the total size is not a power of 2 between
+	the block size and the size of memory.
+*/
+stackDistance_t* createStackDistance(uint32_t blockDataSize, uint32_t maxDataSize);
+
+/*
+	Takes in a block size, the largest total data size of interest, and a
+	sampling rate above 0 and at most 1 and creates a tracker in the same
+	way as createStackDistance that only tracks that fraction of the
+	blocks, picked by hashing their addresses. The hit rates it gives are
+	estimates, and its timelines and its time per access shrink with the
+	rate. Returns NULL if the parameters are not valid.
+*/
+stackDistance_t* createSampledStackDistance(uint32_t blockDataSize, uint32_t maxDataSize, double rate);
+
+/*
+	Takes in a stack distance tracker and frees everything it uses.
+*/
+void deleteStackDistance(stackDistance_t* tracker);
+
+/*
+	Takes in a stack distance tracker and a valid address and records one
+	access to the block holding the address.
+*/
+void recordAccess(stackDistance_t* tracker, uint32_t address);
+
+/*
+	Takes in a stack distance tracker, an array of requests, and the number
+	of requests and records the accesses accessBatch would make for them.
+	Invalid requests are skipped and a request wider than a block is one
+	access to every block it covers.
+*/
+void recordRequests(stackDistance_t* tracker, cacheRequest_t* requests, uint32_t count);
+
+/*
+	Takes in a stack distance tracker, an associativity, and a total data
+	size and returns the hit rate an LRU cache with those parameters and
+	the tracker's block size would have had over the recorded accesses.
+	Returns -1 if the tracker does not cover the cache. For a sampled
+	tracker the hit rate is estimated from the sampled accesses, counting
+	the difference between the expected and the actual number of sampled
+	accesses as hits, and is most accurate for caches with many more ways
+	than 1 / rate.
+*/
+double stackHitRate(stackDistance_t* tracker, uint32_t n, uint32_t totalDataSize);
+#endif
@@ -18,24 +18,17 @@
 	and calls the appropriate functions on the cache being selected to read
 	the data. Returns the data.
 */
-uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint8_t size) {
+uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint8_t size) {
 	uint8_t* retVal;
 	uint8_t offset;
 	uint8_t* transferData;
 	evictionInfo_t* dstCacheInfo;
 	evictionInfo_t* otherCacheInfo;
 	uint32_t evictionBlockNumber;
-	cacheNode_t** caches;
 	bool otherCacheContains = false;
 	cache_t* dstCache = NULL;
-	uint8_t counter = 0;
-	caches = cacheSystem->caches;
-	while (dstCache == NULL && counter < cacheSystem->size) { //Selects destination cache pointer from array of caches pointers
-		if (caches[counter]->ID == ID) {
-			dstCache = caches[counter]->cache;
-		}
-		counter++;
-	}
+	snoopy_t* home = homeSnooper(cacheSystem, address);
+	dstCache = getCacheFromID(cacheSystem, ID); //Selects destination cache pointer from the index of the system
 	dstCacheInfo = findEviction(dstCache, address); //Finds block to evict and potential match
 	evictionBlockNumber = dstCacheInfo->blockNumber;
 	offset = getOffset(dstCache, address);
@@ -44,22 +37,41 @@ uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 		retVal = readFromCache(dstCache, address, size);	// If it is in the cache, read it (read hit)
 	} else {
 		uint32_t oldAddress = extractAddress(dstCache, extractTag(dstCache, evictionBlockNumber), evictionBlockNumber, 0);
+		snoopy_t* oldHome = homeSnooper(cacheSystem, oldAddress);
+		bool valid = getValid(dstCache, evictionBlockNumber);		// An invalid block holds no address to drop
+		bool evicted = valid && snooperContains(oldHome, oldAddress, ID);
+		if (evicted) {
+			countEviction(cacheSystem);
+			if (getDirty(dstCache, evictionBlockNumber)) {
+				countData(cacheSystem);		// The block is written back
+			}
+		}
 		/*How do you need to update the snooper?*/
 		/*How do you need to update states for what is getting evicted
 		(don't worry about evicting, this will be handled at a later step when you place data in the cache)?*/
-		removeFromSnooper(cacheSystem->snooper, oldAddress, ID, size);	// Not necessary to keep track anymore
+		if (valid) {
+			removeFromSnooper(oldHome, oldAddress, ID, size);	// Not necessary to keep track anymore
+		}
 		//evict(dstCache, dstCacheInfo->blockNumber);
 		//evict(dstCache, dstCacheInfo->blockNumber);
 		//setState(dstCache,dstCacheInfo->blockNumber,INVALID);
-		int otherID = returnIDIf1(cacheSystem->snooper, oldAddress, cacheSystem->blockDataSize);
+		int otherID = evicted ? returnIDIf1(oldHome, oldAddress, cacheSystem->blockDataSize) : -1;
 		if (otherID != -1) { 														// If the other block is the only one that had the oldAddr
 			updateState(getCacheFromID(cacheSystem, otherID), oldAddress, INVALID); // We update that state to MODIFIED/EXCLUSIVE
+			countForward(cacheSystem);		// The home tells the last holder
 		}
 
-		int val = returnFirstCacheID(cacheSystem->snooper, address, cacheSystem->blockDataSize);
+		int val = returnFirstCacheID(home, address, cacheSystem->blockDataSize);
+		if (val == ID) {		// The reader missed, so an entry of its own is stale
+			removeFromSnooper(home, address, ID, cacheSystem->blockDataSize);
+			val = returnFirstCacheID(home, address, cacheSystem->blockDataSize);
+		}
+		countRequest(cacheSystem);
+		countData(cacheSystem);		// From the holder or from memory
 		/*Check other caches???*/
 		if (val != -1) { // ProbeRead
 			otherCacheContains = 1;
+			countForward(cacheSystem);
 			otherCacheInfo = findEviction(getCacheFromID(cacheSystem, val), address);					// Find block to be copied
 			transferData = fetchBlock(getCacheFromID(cacheSystem, val), otherCacheInfo->blockNumber);	// Fetch the whole block
 			//printCache(dstCache);
@@ -80,7 +92,7 @@ uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 		}
 		retVal = getData(dstCache, offset, evictionBlockNumber, size);
 	}
-	addToSnooper(cacheSystem->snooper, address, ID, cacheSystem->blockDataSize);
+	addToSnooper(home, address, ID, cacheSystem->blockDataSize);
 	if (otherCacheContains) {
 		/*What states need to be updated?*/
 		/*Your Code Here*/
@@ -96,7 +108,7 @@ uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-byteInfo_t cacheSystemByteRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID) {
+byteInfo_t cacheSystemByteRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID) {
 	byteInfo_t retVal;
 	uint8_t* data;
 	/* Error Checking??*/
@@ -120,7 +132,7 @@ byteInfo_t cacheSystemByteRead(cacheSystem_t* cacheSystem, uint32_t address, uin
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-halfWordInfo_t cacheSystemHalfWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID) {
+halfWordInfo_t cacheSystemHalfWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID) {
 	byteInfo_t temp;
 	halfWordInfo_t retVal;
 	uint8_t* data;
@@ -154,7 +166,7 @@ halfWordInfo_t cacheSystemHalfWordRead(cacheSystem_t* cacheSystem, uint32_t addr
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-wordInfo_t cacheSystemWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID) {
+wordInfo_t cacheSystemWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID) {
 	halfWordInfo_t temp;
 	wordInfo_t retVal;
 	uint8_t* data;
@@ -189,7 +201,7 @@ wordInfo_t cacheSystemWordRead(cacheSystem_t* cacheSystem, uint32_t address, uin
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-doubleWordInfo_t cacheSystemDoubleWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID) {
+doubleWordInfo_t cacheSystemDoubleWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID) {
 	wordInfo_t temp;
 	doubleWordInfo_t retVal;
 	uint8_t* data;
@@ -8,7 +8,7 @@
 	and calls the appropriate functions on the cache being selected to read
 	the data. Returns the data if successful and otherwise NULL.
 */
-uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint8_t size);
+uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint8_t size);
 
 /*
 	A function used to request a byte from a specific cache in a cache system.
@@ -16,7 +16,7 @@ uint8_t* cacheSystemRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-byteInfo_t cacheSystemByteRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID);
+byteInfo_t cacheSystemByteRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID);
 
 /*
 	A function used to request a halfword from a specific cache in a cache system.
@@ -24,7 +24,7 @@ byteInfo_t cacheSystemByteRead(cacheSystem_t* cacheSystem, uint32_t address, uin
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-halfWordInfo_t cacheSystemHalfWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID);
+halfWordInfo_t cacheSystemHalfWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID);
 
 /*
 	A function used to request a word from a specific cache in a cache system.
@@ -32,7 +32,7 @@ halfWordInfo_t cacheSystemHalfWordRead(cacheSystem_t* cacheSystem, uint32_t addr
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-wordInfo_t cacheSystemWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID);
+wordInfo_t cacheSystemWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID);
 
 /*
 	A function used to request a doubleword from a specific cache in a cache system.
@@ -40,5 +40,5 @@ wordInfo_t cacheSystemWordRead(cacheSystem_t* cacheSystem, uint32_t address, uin
 	read from. Returns a struct with the data and a bool field indicating
 	whether or not the read was a success.
 */
-doubleWordInfo_t cacheSystemDoubleWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID);
+doubleWordInfo_t cacheSystemDoubleWordRead(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID);
 #endif
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "../part1/utils.h"
 #include "../part1/setInCache.h"
 #include "../part1/getFromCache.h"
+#include "../part1/mem.h"
+#include "../part1/replacement.h"
 
 /*
 	Used to indicate that a cache system has an invalid number
@@ -61,7 +63,7 @@ void memError() {
 	a cache node. You CAN assume that the cache has already been properly
 	malloced.
 */
-cacheNode_t* createCacheNode(cache_t* cache, uint8_t ID) {
+cacheNode_t* createCacheNode(cache_t* cache, uint16_t ID) {
 	cacheNode_t* node = malloc(sizeof(cacheNode_t));
 	if (node == NULL) {
 		allocationFailed();
@@ -72,15 +74,15 @@ cacheNode_t* createCacheNode(cache_t* cache, uint8_t ID) {
 }
 
 /*
-	Function that creates a cache system. Takes in an array of cache
-	nodes and a size and returns a pointer to the cache system.
-	All caches must have the same block data size and no two caches can share
-	an ID. In addition all caches in a system must share the same main memory
-	source. IF any condition is failed call the appropriate error function
-	and return NULL.
+	Takes in an array of cache nodes, a size, a mode, and a snooper, which
+	only SNOOPING needs, and checks the conditions of createCacheSystem,
+	calling the appropriate error function and returning NULL if any is
+	failed. Otherwise returns a cache system with its ID index built and no
+	trackers.
 */
-cacheSystem_t* createCacheSystem(cacheNode_t** caches, uint8_t size, snoopy_t* snooper) {
-	char* memFile;
+static cacheSystem_t* buildCacheSystem(cacheNode_t** caches, uint32_t size, enum coherenceMode mode,
+	snoopy_t* snooper) {
+	physicalMemory_t* memory;
 	int ID;
 	cache_t* cache;
 	if (caches == NULL) {
@@ -91,55 +93,104 @@ cacheSystem_t* createCacheSystem(cacheNode_t** caches, uint8_t size, snoopy_t* s
 		invalidCacheNumber();
 		return NULL;
 	}
-	if (snooper == NULL) {
+	if (mode == SNOOPING && snooper == NULL) {
 		snooperError();
 		return NULL;
 	}
-	int ID_Array[size];
-	cache_t* cache_Array[size];
 	if (caches[0] == NULL || caches[0]->cache == NULL) {
 		nullCacheError();
 		return NULL;
 	}
 	uint32_t blockDataSize = caches[0]->cache->blockDataSize;
-	ID_Array[0] = caches[0]->ID;
-	cache_Array[0] = caches[0]->cache;
-	memFile = caches[0]->cache->physicalMemoryName;
-	for (uint8_t i = 1; i < size; i++) {
+	uint32_t indexSize = caches[0]->ID + 1;
+	memory = caches[0]->cache->memory;
+	for (uint32_t i = 1; i < size; i++) {
 		if (caches[i] == NULL || caches[i]->cache == NULL) {
 			nullCacheError();
 			return NULL;
 		} else if (caches[i]->cache->blockDataSize != blockDataSize) {
 			blockSizeError();
 			return NULL;
-		} else if (strcmp(caches[i]->cache->physicalMemoryName, memFile)) {
+		} else if (caches[i]->cache->memory != memory) {
 			memError();
 			return NULL;
-		} else {
-			ID = caches[i]->ID;
-			cache = caches[i]->cache;
-			for (uint8_t j = 0; j < i; j++) {
-				if (ID == ID_Array[j]) {
-					duplicateIDError();
-					return NULL;
-				}
-				if (cache == cache_Array[j]) {
-					nullCacheError();
-					return NULL;
-				}
+		}
+		if (caches[i]->ID >= indexSize) {
+			indexSize = caches[i]->ID + 1;
+		}
+	}
+	cacheNode_t** index = calloc(indexSize, sizeof(cacheNode_t*));
+	if (index == NULL) {
+		allocationFailed();
+	}
+	for (uint32_t i = 0; i < size; i++) {
+		ID = caches[i]->ID;
+		cache = caches[i]->cache;
+		if (index[ID] != NULL) {
+			duplicateIDError();
+			free(index);
+			return NULL;
+		}
+		for (uint32_t j = 0; j < i; j++) {
+			if (cache == caches[j]->cache) {
+				nullCacheError();
+				free(index);
+				return NULL;
 			}
-			ID_Array[i] = ID;
-			cache_Array[i] = cache;
 		}
+		index[ID] = caches[i];
 	}
 	cacheSystem_t* sys = malloc(sizeof(cacheSystem_t));
 	if (sys == NULL) {
 		allocationFailed();
 	}
 	sys->caches = caches;
+	sys->index = index;
+	sys->indexSize = indexSize;
 	sys->size = size;
 	sys->blockDataSize = blockDataSize;
-	sys->snooper = snooper;
+	sys->snooper = NULL;
+	sys->memory = retainPhysicalMemory(memory);
+	sys->mode = mode;
+	sys->homes = NULL;
+	memset(&sys->traffic, 0, sizeof(coherenceTraffic_t));
+	return sys;
+}
+
+/*
+	Function that creates a cache system. Takes in an array of cache
+	nodes and a size and returns a pointer to the cache system.
+	All caches must have the same block data size and no two caches can share
+	an ID. In addition all caches in a system must share the same main memory
+	object. IF any condition is failed call the appropriate error function
+	and return NULL.
+*/
+cacheSystem_t* createCacheSystem(cacheNode_t** caches, uint32_t size, snoopy_t* snooper) {
+	cacheSystem_t* sys = buildCacheSystem(caches, size, SNOOPING, snooper);
+	if (sys != NULL) {
+		sys->snooper = snooper;
+	}
+	return sys;
+}
+
+/*
+	Function that creates a cache system kept coherent by a directory. Takes in
+	an array of cache nodes and a size, with the same conditions as
+	createCacheSystem, and returns a pointer to the cache system, or NULL if
+	any condition is failed.
+*/
+cacheSystem_t* createDirectorySystem(cacheNode_t** caches, uint32_t size) {
+	cacheSystem_t* sys = buildCacheSystem(caches, size, DIRECTORY, NULL);
+	if (sys == NULL) {
+		return NULL;
+	}
+	sys->homes = malloc(sizeof(snoopy_t*) * size);
+	if (sys->homes == NULL) {
+		allocationFailed();
+	}
+	for (uint32_t i = 0; i < size; i++) {
+		sys->homes[i] = createSnooper();
+	}
 	return sys;
 }
 
@@ -149,13 +200,24 @@ cacheSystem_t* createCacheSystem(cacheNode_t** caches, uint8_t size, snoopy_t* s
 */
 void deleteCacheSystem(cacheSystem_t* cacheSystem) {
 	cacheNode_t* node;
-	for (int i = 0; i < cacheSystem->size; i++) {
+	for (uint32_t i = 0; i < cacheSystem->size; i++) {
 		node = cacheSystem->caches[i];
 		deleteCache(node->cache);
 		free(node);
 	}
 	free(cacheSystem->caches);
-	deleteSnooper(cacheSystem->snooper);
+	free(cacheSystem->index);
+	if (cacheSystem->snooper != NULL) {
+		deleteSnooper(cacheSystem->snooper);
+	}
+	if (cacheSystem->homes != NULL) {
+		for (uint32_t i = 0; i < cacheSystem->size; i++) {
+			deleteSnooper(cacheSystem->homes[i]);
+		}
+		free(cacheSystem->homes);
+	}
+	flushPhysicalMemory(cacheSystem->memory);
+	releasePhysicalMemory(cacheSystem->memory);
 	free(cacheSystem);
 }
 
@@ -164,16 +226,75 @@ void deleteCacheSystem(cacheSystem_t* cacheSystem) {
 	that is being stored in node with that ID number. If the ID number is not
 	valid for the cache system then it returns a NULL pointer.
 */
-cache_t* getCacheFromID(cacheSystem_t* cacheSystem, uint8_t ID) {
-	cacheNode_t* node;
-	uint8_t size = cacheSystem->size;
-	for (unsigned int i = 0; i < size; i++) {
-		node = cacheSystem->caches[i];
-		if (node->ID == ID) {
-			return node->cache;
-		}
+cache_t* getCacheFromID(cacheSystem_t* cacheSystem, uint16_t ID) {
+	if (ID >= cacheSystem->indexSize || cacheSystem->index[ID] == NULL) {
+		return NULL;
+	}
+	return cacheSystem->index[ID]->cache;
+}
+
+/*
+	Takes in a cache system and an address and returns the snooper that tracks
+	the block of the address: the snooper of the system, or with DIRECTORY the
+	directory of the home of the block.
+*/
+snoopy_t* homeSnooper(cacheSystem_t* cacheSystem, uint32_t address) {
+	if (cacheSystem->mode == SNOOPING) {
+		return cacheSystem->snooper;
+	}
+	return cacheSystem->homes[(address / cacheSystem->blockDataSize) % cacheSystem->size];
+}
+
+/*
+	Takes in a cache system and counts a request of one of its caches, which is
+	broadcast to every other cache or sent to the home of the block.
+*/
+void countRequest(cacheSystem_t* cacheSystem) {
+	cacheSystem->traffic.requests++;
+	cacheSystem->traffic.messages += cacheSystem->mode == SNOOPING ? cacheSystem->size - 1 : 1;
+}
+
+/*
+	Takes in a cache system and counts a request passed on to a cache that holds
+	the block. Only a directory sends it as a message, as every cache sees a
+	broadcast request.
+*/
+void countForward(cacheSystem_t* cacheSystem) {
+	cacheSystem->traffic.forwards++;
+	cacheSystem->traffic.messages += cacheSystem->mode == DIRECTORY;
+}
+
+/*
+	Takes in a cache system and a number of caches and counts an invalidation
+	of each of them. Only a directory sends the invalidations and their acks as
+	messages.
+*/
+void countInvalidations(cacheSystem_t* cacheSystem, uint32_t count) {
+	cacheSystem->traffic.invalidations += count;
+	if (cacheSystem->mode == DIRECTORY) {
+		cacheSystem->traffic.acks += count;
+		cacheSystem->traffic.messages += 2 * (uint64_t) count;
+	}
+}
+
+/*
+	Takes in a cache system and counts a block sent to or from a cache.
+*/
+void countData(cacheSystem_t* cacheSystem) {
+	cacheSystem->traffic.data++;
+	cacheSystem->traffic.messages++;
+}
+
+/*
+	Takes in a cache system and counts a cache dropping a block, which only a
+	directory has to learn of. Under snooping a clean block is dropped
+	silently and a dirty one only costs its writeback.
+*/
+void countEviction(cacheSystem_t* cacheSystem) {
+	if (cacheSystem->mode == DIRECTORY) {
+		cacheSystem->traffic.evictions++;
+		cacheSystem->traffic.messages++;
 	}
-	return NULL;
 }
 
 /*
@@ -250,28 +371,25 @@ void updateState(cache_t* cache, uint32_t address, enum state otherState) {
     evictionInfo_t* blockInfo = findEviction(cache, address);
     uint32_t blockNumber = blockInfo->blockNumber;
     enum state currState = determineState(cache, address);
-    uint32_t tag =  extractTag(cache, blockNumber);
-    uint32_t index = extractIndex(cache, blockNumber);
-    long oldLRU = blockInfo->LRU;
 
     switch(otherState) {
         case MODIFIED:      // DONE
             switch(currState) {
                 case MODIFIED:
                     setState(cache, blockNumber, INVALID);
-                    decrementLRU(cache, tag, index, oldLRU);
+                    decrementLRU(cache, blockNumber);
                     break;
                 case OWNED: // DONE
                     setState(cache, blockNumber, INVALID);
-                    decrementLRU(cache, tag, index, oldLRU);
+                    decrementLRU(cache, blockNumber);
                     break;
                 case EXCLUSIVE:
                     setState(cache, blockNumber, INVALID);
-                    decrementLRU(cache, tag, index, oldLRU);
+                    decrementLRU(cache, blockNumber);
                     break;
                 case SHARED: // DONE
                     setState(cache, blockNumber, INVALID);
-                    decrementLRU(cache, tag, index, oldLRU);
+                    decrementLRU(cache, blockNumber);
                     break;
 
                 case INVALID:
@@ -322,16 +440,25 @@ void updateState(cache_t* cache, uint32_t address, enum state otherState) {
 }
 
 /*
-	Creates a new snooper with 8 buckets.
+	Creates a new snooper with SNOOPER_SLOTS slots.
 */
 snoopy_t* createSnooper() {
 	snoopy_t* snoopy = malloc(sizeof(snoopy_t));
-	snoopy->buckets = malloc(sizeof(snoopBucket_t*) << 3);
-	for (int i = 0; i < 8; i++) {
-		snoopy->buckets[i] = createBucket();
+	if (snoopy == NULL) {
+		allocationFailed();
 	}
-	snoopy->numBuckets = 8;
+	snoopy->numSlots = SNOOPER_SLOTS;
 	snoopy->numContents = 0;
+	snoopy->sharerWords = 1;
+	snoopy->addresses = calloc(SNOOPER_SLOTS, sizeof(uint32_t));
+	snoopy->sharers = calloc(SNOOPER_SLOTS, sizeof(uint64_t));
+	if (snoopy->addresses == NULL || snoopy->sharers == NULL) {
+		allocationFailed();
+	}
+	snoopy->oldAddresses = NULL;
+	snoopy->oldSharers = NULL;
+	snoopy->oldSlots = 0;
+	snoopy->migrated = 0;
 	return snoopy;
 }
 
@@ -339,125 +466,189 @@ snoopy_t* createSnooper() {
 	Takes in a snooper and deletes all the elements.
 */
 void deleteSnooper(snoopy_t* snooper) {
-	addressList_t* lst;
-	addressList_t* nxtlst;
-	snoopBucket_t* bucket;
-	for (int i = 0; i < snooper->numBuckets; i++) {
-		bucket = snooper->buckets[i];
-		if (bucket->lst) {
-			lst = bucket->lst;
-			while (lst) {
-				nxtlst = lst->next;
-				free(lst);
-				lst = nxtlst;
-			}
+	free(snooper->addresses);
+	free(snooper->sharers);
+	free(snooper->oldAddresses);
+	free(snooper->oldSharers);
+	free(snooper);
+}
+
+/*
+	Hash function used to place addresses in a snooper.
+*/
+uint32_t hash(uint32_t address) {
+    return (uint32_t) (((uint64_t) address * UINT32_C(2654435761)) >> 16); //Adapted from Knuth's multiplicative has function TAOCP volume 3 (2nd edition), section 6.4, page 516.
+}
+
+/*
+	Takes in the addresses of a table, its number of slots, and a block
+	address and probes the table from the hash of the address. Returns true
+	and sets index to the slot of the address if it is in the table.
+*/
+static bool findSlot(uint32_t* addresses, uint64_t slots, uint32_t address, uint64_t* index) {
+	uint64_t mask = slots - 1;
+	for (uint64_t i = hash(address) & mask; addresses[i] != SNOOPER_EMPTY; i = (i + 1) & mask) {
+		if (addresses[i] == address) {
+			*index = i;
+			return true;
 		}
-		free(bucket);
 	}
-	free(snooper->buckets);
-	free(snooper);
+	return false;
 }
 
 /*
-	Creates a bucket for the snooper.
+	Takes in a snooper and a block address and returns the sharer vector of
+	the address, from whichever table holds it, or NULL if no cache holds
+	the address.
 */
-snoopBucket_t* createBucket() {
-	snoopBucket_t* bucket;
-	bucket = malloc(sizeof(snoopBucket_t));
-	bucket->lst = NULL;
-	return bucket;
+static uint64_t* findSharers(snoopy_t* snooper, uint32_t address) {
+	uint64_t index;
+	if (findSlot(snooper->addresses, snooper->numSlots, address, &index)) {
+		return &snooper->sharers[index * snooper->sharerWords];
+	}
+	if (snooper->oldAddresses != NULL && findSlot(snooper->oldAddresses, snooper->oldSlots, address, &index)) {
+		return &snooper->oldSharers[index * snooper->sharerWords];
+	}
+	return NULL;
 }
 
 /*
-	Creates a new list to keep track of IDs and addresses.
+	Takes in a snooper with a free slot in its current table and a block
+	address that is in neither table and places the address in the first
+	free slot from its hash. Returns the slot.
 */
-addressList_t* createList(uint32_t address, uint8_t ID, addressList_t* next) {
-	addressList_t* lst = malloc(sizeof(addressList_t));
-	lst->address = address;
-	lst->ID = ID;
-	lst->next = next;
-	return lst;
+static uint64_t insertEntry(snoopy_t* snooper, uint32_t address) {
+	uint64_t mask = snooper->numSlots - 1;
+	uint64_t i = hash(address) & mask;
+	while (snooper->addresses[i] != SNOOPER_EMPTY) {
+		i = (i + 1) & mask;
+	}
+	snooper->addresses[i] = address;
+	return i;
 }
 
 /*
-	Hash function used to place addresses in a snooper.
+	Takes in a snooper and the slot of an entry of its current table and
+	removes the entry, moving later entries of the same run back into the
+	hole so every probe still reaches them.
 */
-uint32_t hash(uint32_t address) {
-    return (uint32_t) (((uint64_t) address * UINT32_C(2654435761)) >> 16); //Adapted from Knuth's multiplicative has function TAOCP volume 3 (2nd edition), section 6.4, page 516.
+static void removeEntry(snoopy_t* snooper, uint64_t hole) {
+	uint32_t* addresses = snooper->addresses;
+	uint32_t words = snooper->sharerWords;
+	uint64_t mask = snooper->numSlots - 1;
+	for (uint64_t i = (hole + 1) & mask; addresses[i] != SNOOPER_EMPTY; i = (i + 1) & mask) {
+		uint64_t home = hash(addresses[i]) & mask;
+		if (((i - home) & mask) >= ((i - hole) & mask)) {		// The hole lies between its home and it
+			addresses[hole] = addresses[i];
+			memcpy(&snooper->sharers[hole * words], &snooper->sharers[i * words], words * sizeof(uint64_t));
+			hole = i;
+		}
+	}
+	addresses[hole] = SNOOPER_EMPTY;
+	memset(&snooper->sharers[hole * words], 0, words * sizeof(uint64_t));
+}
+
+/*
+	Takes in a snooper and a number of words and widens every sharer vector
+	to that many words, first finishing any resize still under way.
+*/
+static void widenSharers(snoopy_t* snooper, uint32_t words) {
+	while (snooper->oldAddresses != NULL) {
+		migrateSnooper(snooper);
+	}
+	uint64_t* sharers = calloc((size_t) snooper->numSlots * words, sizeof(uint64_t));
+	if (sharers == NULL) {
+		allocationFailed();
+	}
+	for (uint64_t i = 0; i < snooper->numSlots; i++) {
+		memcpy(&sharers[i * words], &snooper->sharers[i * snooper->sharerWords], snooper->sharerWords * sizeof(uint64_t));
+	}
+	free(snooper->sharers);
+	snooper->sharers = sharers;
+	snooper->sharerWords = words;
 }
 
 /*
-	Adds a new list to the snooper. If a list with the same address and ID is already
-	there it does nothing. Otherwise it finds its appropriate bucket for that address and
-	appends it to the front of our list. If capacity becomes twice the number of buckets
-	the number of buckets should shift.
+	Adds a new entry to the snooper. If an entry with the same address and ID is
+	already there it does nothing. Otherwise the ID is set in the sharer vector
+	of the address, which takes the first free slot from the hash of the address
+	if no cache held it. If half of the slots become used the snooper starts to
+	resize.
 */
-void addToSnooper(snoopy_t* snooper, uint32_t address, uint8_t ID, uint32_t blockDataSize) {
-	uint32_t hashVal;
+void addToSnooper(snoopy_t* snooper, uint32_t address, uint16_t ID, uint32_t blockDataSize) {
 	address = address & ~(blockDataSize - 1);
-	if (!snooperContains(snooper, address, ID)) {
+	if (ID >= snooper->sharerWords * SNOOPER_SHARER_BITS) {
+		widenSharers(snooper, ID / SNOOPER_SHARER_BITS + 1);
+	}
+	uint64_t* sharers = findSharers(snooper, address);
+	if (sharers == NULL) {
 		snooper->numContents++;
-		if (snooper->numContents >= (snooper->numBuckets << 1)) {
+		if (snooper->numContents * 2 > snooper->numSlots) {
 			resizeSnooper(snooper);
 		}
-		hashVal = hash(address) & (snooper->numBuckets - 1);
-		snooper->buckets[hashVal]->lst = createList(address, ID, snooper->buckets[hashVal]->lst);
+		sharers = &snooper->sharers[insertEntry(snooper, address) * snooper->sharerWords];
 	}
+	sharers[ID / SNOOPER_SHARER_BITS] |= UINT64_C(1) << (ID % SNOOPER_SHARER_BITS);
+	migrateSnooper(snooper);
 }
 
 /*
 	Takes in a snooper, an address, and an ID. Returns true if the snooper
-	contains a list containing the address and ID.
-*/
-bool snooperContains(snoopy_t* snooper, uint32_t address, uint8_t ID) {
-	uint32_t hashVal;
-	hashVal = hash(address) & (snooper->numBuckets - 1);
-	addressList_t* lst = snooper->buckets[hashVal]->lst;
-	while (lst) {
-		if (lst->address == address && lst->ID == ID) {
-			return true;
-		}
-		lst = lst->next;
-	}
-	return false;
+	contains an entry with the address and ID.
+*/
+bool snooperContains(snoopy_t* snooper, uint32_t address, uint16_t ID) {
+	uint64_t* sharers = findSharers(snooper, address);
+	return sharers != NULL && ID < snooper->sharerWords * SNOOPER_SHARER_BITS
+		&& (sharers[ID / SNOOPER_SHARER_BITS] >> (ID % SNOOPER_SHARER_BITS)) & 1;
 }
 
 /*
-	Resizes the snooper if the load factor becomes >= 2.
+	Starts to move the snooper to a table with twice as many slots, first
+	finishing any resize still under way. Called when half of the slots
+	are used.
 */
 void resizeSnooper(snoopy_t* snooper) {
-	uint32_t hashVal;
-	snoopBucket_t* bucket;
-	addressList_t* frontlst = NULL;
-	addressList_t* lstMover = NULL;
-	for (int i = 0; i < snooper->numBuckets; i++) {
-		bucket = snooper->buckets[i];
-		if (bucket->lst) {
-			if (frontlst == NULL) {
-				frontlst = bucket->lst;
-				lstMover = bucket->lst;
-			} else {
-				lstMover->next = bucket->lst;
-			}
-			while (lstMover->next) {
-				lstMover = lstMover->next;
-			}
-		}
-		bucket->lst = NULL;
-	}
-	snooper->numBuckets = (snooper->numBuckets) << 1;
-	snooper->buckets = realloc(snooper->buckets, sizeof(snoopBucket_t*) << log_2(snooper->numBuckets));
-	for (int i = (snooper->numBuckets) >> 1; i < snooper->numBuckets; i++) {
-		snooper->buckets[i] = createBucket();
+	while (snooper->oldAddresses != NULL) {
+		migrateSnooper(snooper);
 	}
-	while (frontlst) {
-		lstMover = frontlst;
-		frontlst = frontlst->next;
-		hashVal = hash(lstMover->address) & (snooper->numBuckets - 1);
-		lstMover->next = snooper->buckets[hashVal]->lst;
-		snooper->buckets[hashVal]->lst = lstMover;
+	snooper->oldAddresses = snooper->addresses;
+	snooper->oldSharers = snooper->sharers;
+	snooper->oldSlots = snooper->numSlots;
+	snooper->migrated = 0;
+	snooper->numSlots = snooper->numSlots << 1;
+	snooper->addresses = calloc(snooper->numSlots, sizeof(uint32_t));
+	snooper->sharers = calloc((size_t) snooper->numSlots * snooper->sharerWords, sizeof(uint64_t));
+	if (snooper->addresses == NULL || snooper->sharers == NULL) {
+		allocationFailed();
 	}
+}
 
+/*
+	Moves the entries of the next SNOOPER_MIGRATE_STEP slots of the old
+	table of a snooper that is resizing and frees the old table once
+	every slot has moved. Does nothing if no resize is under way.
+*/
+void migrateSnooper(snoopy_t* snooper) {
+	if (snooper->oldAddresses == NULL) {
+		return;
+	}
+	uint32_t words = snooper->sharerWords;
+	for (int i = 0; i < SNOOPER_MIGRATE_STEP && snooper->migrated < snooper->oldSlots; i++) {
+		uint64_t slot = snooper->migrated++;
+		uint32_t address = snooper->oldAddresses[slot];
+		if (address != SNOOPER_EMPTY && address != SNOOPER_MOVED) {
+			uint64_t index = insertEntry(snooper, address);
+			memcpy(&snooper->sharers[index * words], &snooper->oldSharers[slot * words], words * sizeof(uint64_t));
+			snooper->oldAddresses[slot] = SNOOPER_MOVED;
+		}
+	}
+	if (snooper->migrated == snooper->oldSlots) {
+		free(snooper->oldAddresses);
+		free(snooper->oldSharers);
+		snooper->oldAddresses = NULL;
+		snooper->oldSharers = NULL;
+		snooper->oldSlots = 0;
+	}
 }
 
 /*
@@ -465,89 +656,110 @@ void resizeSnooper(snoopy_t* snooper) {
 	 that contains the info if it is the sole cache. Otherwise it returns -1.
 */
 int returnIDIf1(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize) {
-	int ID;
-	uint8_t count;
-	uint32_t hashVal;
-	addressList_t* lst;
 	address = address & ~(blockDataSize - 1);
-	ID = -1;
-	hashVal = hash(address) & (snooper->numBuckets - 1);
-	lst = snooper->buckets[hashVal]->lst;
-	count = 0;
-	while (lst && count < 2) {
-		if (address == lst->address) {
-			count++;
-			ID = lst->ID;
+	uint64_t* sharers = findSharers(snooper, address);
+	if (sharers == NULL) {
+		return -1;
+	}
+	int ID = -1;
+	for (uint32_t i = 0; i < snooper->sharerWords; i++) {
+		if (sharers[i] == 0) {
+			continue;
+		}
+		if (ID != -1 || __builtin_popcountll(sharers[i]) > 1) {
+			return -1;
 		}
-		lst = lst->next;
+		ID = i * SNOOPER_SHARER_BITS + __builtin_ctzll(sharers[i]);
 	}
-	return count < 2 ? ID : -1;
+	return ID;
 }
 
 /*
-	Takes in a snooper, an address, and a blocksize and returns the first
-	cache to contain the address. Returns -1 if there are none.
+	Takes in a snooper, an address, and a blocksize and returns the cache with
+	the lowest ID that contains the address. Returns -1 if there are none.
 */
 int returnFirstCacheID(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize) {
-	uint32_t hashVal;
+	return returnNextCacheID(snooper, address, blockDataSize, -1);
+}
+
+/*
+	Takes in a snooper, an address, a blocksize, and an ID or -1 and returns
+	the cache with the lowest ID above it that contains the address. Returns
+	-1 if there are none.
+*/
+int returnNextCacheID(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize, int ID) {
 	address = address & ~(blockDataSize - 1);
-	hashVal = hash(address) & (snooper->numBuckets - 1);
-	addressList_t* lst = snooper->buckets[hashVal]->lst;
-	while (lst) {
-		if (address == lst->address) {
-			return lst->ID;
+	uint64_t* sharers = findSharers(snooper, address);
+	uint32_t next = ID + 1;
+	if (sharers == NULL) {
+		return -1;
+	}
+	for (uint32_t i = next / SNOOPER_SHARER_BITS; i < snooper->sharerWords; i++) {
+		uint64_t word = sharers[i];
+		if (i == next / SNOOPER_SHARER_BITS) {
+			word &= ~UINT64_C(0) << (next % SNOOPER_SHARER_BITS);
+		}
+		if (word != 0) {
+			return i * SNOOPER_SHARER_BITS + __builtin_ctzll(word);
 		}
-		lst = lst->next;
 	}
 	return -1;
 }
 
 /*
-	Takes in an address and an ID and removes that list content from the table.
-	If the contents are not in the table it does nothing.
+	Takes in a snooper and a block address and drops the entry of the address,
+	which no cache holds any longer.
 */
-void removeFromSnooper(snoopy_t* snooper, uint32_t address, uint8_t ID, uint32_t blockDataSize) {
-	uint32_t hashVal;
-	address = address & ~(blockDataSize - 1);
-	hashVal = hash(address) & (snooper->numBuckets - 1);
-	removeItem(&(snooper->buckets[hashVal]->lst), address, ID);
+static void dropEntry(snoopy_t* snooper, uint32_t address) {
+	uint64_t index = 0;
+	if (findSlot(snooper->addresses, snooper->numSlots, address, &index)) {
+		removeEntry(snooper, index);
+	} else {
+		findSlot(snooper->oldAddresses, snooper->oldSlots, address, &index);
+		snooper->oldAddresses[index] = SNOOPER_MOVED;
+	}
+	snooper->numContents--;
 }
 
 /*
-	Takes in a pointer to a pointer to a list, an address, and an ID and removes
-	the list element from the list that matches the ID. If no element matches
-	it does nothing.
+	Takes in an address and an ID and removes that entry from the table.
+	If the entry is not in the table it does nothing.
 */
-void removeItem(addressList_t** lst, uint32_t address, uint8_t ID) {
-	if (lst == NULL || *lst == NULL) {
-		return;
-	}
-	addressList_t* temp = *lst;
-	if (temp->address == address && temp->ID == ID) {
-		*lst = temp->next;
-		free(temp);
-	} else {
-		return removeItem(&(temp->next), address, ID);
+void removeFromSnooper(snoopy_t* snooper, uint32_t address, uint16_t ID, uint32_t blockDataSize) {
+	address = address & ~(blockDataSize - 1);
+	uint64_t* sharers = findSharers(snooper, address);
+	if (sharers != NULL && ID < snooper->sharerWords * SNOOPER_SHARER_BITS) {
+		sharers[ID / SNOOPER_SHARER_BITS] &= ~(UINT64_C(1) << (ID % SNOOPER_SHARER_BITS));
+		bool empty = true;
+		for (uint32_t i = 0; i < snooper->sharerWords; i++) {
+			empty = empty && sharers[i] == 0;
+		}
+		if (empty) {
+			dropEntry(snooper, address);
+		}
 	}
+	migrateSnooper(snooper);
 }
 
 /*
-	Decrements the LRU of every block by 1 except for the block that just
-	got invalidated which is set to the LRU max value.
+	Takes in a snooper, an address, and a blocksize and removes the address
+	from every cache that holds it in one step, as when a write invalidates
+	all of them. If no cache holds the address it does nothing.
 */
-void decrementLRU(cache_t* cache, uint32_t tag, uint32_t idx, long oldLRU) {
-	int currLRU;
-	uint32_t blockNumber;
-	uint32_t blockNumberStart = idx << log_2(cache->n);
-	for (int i = 0; i < cache->n; i++) {
-		blockNumber = blockNumberStart + i;
-		if (tagEquals(blockNumber, tag, cache)) {
-			setLRU(cache, blockNumber, cache->n - 1);
-		} else if (getValid(cache, blockNumber)) {
-			currLRU = getLRU(cache, blockNumber);
-			if (currLRU > oldLRU) {
-			setLRU(cache, blockNumber, currLRU - 1);
-			}
-		}
+void removeAllFromSnooper(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize) {
+	address = address & ~(blockDataSize - 1);
+	if (findSharers(snooper, address) != NULL) {
+		dropEntry(snooper, address);
 	}
+	migrateSnooper(snooper);
+}
+
+/*
+	Updates the replacement state of the set after the given block just got
+	invalidated. For LRU the block is set to the LRU max value and every
+	valid block older than it is decremented by 1, and other policies
+	usually make the block the next victim of its set.
+*/
+void decrementLRU(cache_t* cache, uint32_t blockNumber) {
+	invalidateReplacement(cache, blockNumber);
 }
@@ -11,57 +11,109 @@
 */
 enum state {MODIFIED, OWNED, EXCLUSIVE, SHARED, INVALID};
 
+/*
+	Enum used to specify how a cache system keeps its caches coherent. With
+	SNOOPING every request is broadcast on a bus that every cache watches and
+	one snooper tracks every block. With DIRECTORY memory is split into one
+	slice per cache, interleaved by block, and every request goes to the home
+	of its block, which tracks the sharers of its slice and only messages the
+	caches involved.
+*/
+enum coherenceMode {SNOOPING, DIRECTORY};
+
+/*
+	Struct used to count the coherence traffic of a cache system. requests
+	counts the read, write, and upgrade requests of caches, forwards the
+	requests passed on to a cache that holds the block, invalidations and
+	acks the invalidations sent and acknowledged, data the blocks sent
+	between caches and memory, and evictions the notices a directory gets
+	of a cache that dropped a block. messages counts every message
+	delivered: a broadcast reaches every other cache, while in a directory
+	every forward, invalidation, and ack is a message of its own.
+*/
+typedef struct coherenceTraffic {
+	uint64_t requests;
+	uint64_t forwards;
+	uint64_t invalidations;
+	uint64_t acks;
+	uint64_t data;
+	uint64_t evictions;
+	uint64_t messages;
+} coherenceTraffic_t;
+
 /*
 	Struct used to contain an individual cache for a coherent system. Consists
 	of a pointer to a cache and an ID.
 */
 typedef struct cacheNode {
 	cache_t* cache;
-	uint8_t ID;
+	uint16_t ID;
 } cacheNode_t;
 
 /*
-	Struct used to contain a list of all addresses and the caches in which
-	they lie. Is a linked list.
+	Settings of the snooper. It starts with SNOOPER_SLOTS slots and doubles
+	once half of them are used. Every add or remove then moves the entries
+	of SNOOPER_MIGRATE_STEP slots of the old table to the new one, so no
+	access pays for the whole resize. Slots whose address is SNOOPER_EMPTY
+	are free, and during a resize slots of the old table whose entry moved
+	or was removed hold SNOOPER_MOVED so probes go on past them. Neither is
+	the address of a block of memory. Sharer vectors are made of words of
+	SNOOPER_SHARER_BITS bits.
 */
-typedef struct addressList {
-	uint32_t address;
-	uint8_t ID;
-	struct addressList* next;
-} addressList_t;
+#define SNOOPER_SLOTS 8
+#define SNOOPER_MIGRATE_STEP 4
+#define SNOOPER_EMPTY 0
+#define SNOOPER_MOVED 1
+#define SNOOPER_SHARER_BITS 64
 
 /*
-	Stuct used to represent each bucket in the snooper. Contains a pointer to
-	a list with an address.
-*/
-typedef struct snoopBucket{
-	addressList_t* lst;
-} snoopBucket_t;
-
-/*
-	Struct used to create the snooper for each cache. Each cache should contain
-	exactly one snooper. The buckets are used to control the actual mapping.
-	The  numContents is the number of elements in the table. If numContents
-	is twice the numBuckets the number of buckets should double. This table
+	Struct used to create the snooper for each cache system. It is a flat
+	table of numSlots entries with linear probing from the hash of the
+	block address. Every block held by any cache has one entry: its address
+	in addresses and, at the same slot, a sharer vector of sharerWords words
+	in sharers with bit ID set for every cache that holds it. sharerWords
+	grows when a cache with a higher ID is added. numContents is the number
+	of blocks held. While a resize is under way oldAddresses and oldSharers
+	hold the previous table of oldSlots slots, whose slots below migrated
+	have been moved, and a block is in one of the two tables. This table
 	will not dynamically shrink.
 */
 typedef struct snoopy{
-	snoopBucket_t** buckets;
-	uint8_t numBuckets;
-	uint8_t numContents;
+	uint32_t* addresses;
+	uint64_t* sharers;
+	uint64_t numSlots;
+	uint64_t numContents;
+	uint32_t sharerWords;
+	uint32_t* oldAddresses;
+	uint64_t* oldSharers;
+	uint64_t oldSlots;
+	uint64_t migrated;
 } snoopy_t;
 
 /*
 	Struct used to contain a network of coherent caches. Consists of a
 	double pointer to cache nodes, a size of the network, and the blockDataSize
 	for the cacehe. All caches must have the same block data size and each have
-	unique IDs.
+	unique IDs. The memory is the main memory every cache in the system fills
+	from and writes back to. The system holds a reference to it and flushes
+	it once when the system is deleted. index has indexSize entries, one
+	past the highest ID, and entry ID points to the node with that ID or is
+	NULL, so a cache is found from its ID without searching. mode is how the
+	caches are kept coherent. With DIRECTORY homes holds the directory of each
+	of the size slices of memory and snooper is NULL. traffic counts
+	the coherence messages the system has sent.
 */
 typedef struct cacheSystem{
 	cacheNode_t** caches;
-	uint8_t size;
+	uint32_t size;
+	cacheNode_t** index;
+	uint32_t indexSize;
 	uint32_t blockDataSize;
 	snoopy_t* snooper;
+	physicalMemory_t* memory;
+	enum coherenceMode mode;
+	snoopy_t** homes;
+	coherenceTraffic_t traffic;
 } cacheSystem_t;
 
 /*
@@ -104,17 +156,25 @@ void memError();
 	a cache node. You CAN assume that the cache has already been properly
 	malloced.
 */
-cacheNode_t* createCacheNode(cache_t* cache, uint8_t ID);
+cacheNode_t* createCacheNode(cache_t* cache, uint16_t ID);
 
 /*
 	Function that creates a cache system. Takes in an array of cache
 	nodes and a size and returns a pointer to the cache system.
 	All caches must have the same block data size and no two caches can share
 	an ID. In addition all caches in a system must share the same main memory
-	source. IF any condition is failed call the appropriate error function
+	object. IF any condition is failed call the appropriate error function
 	and return NULL.
 */
-cacheSystem_t* createCacheSystem(cacheNode_t** caches, uint8_t size, snoopy_t* snooper);
+cacheSystem_t* createCacheSystem(cacheNode_t** caches, uint32_t size, snoopy_t* snooper);
+
+/*
+	Function that creates a cache system kept coherent by a directory. Takes in
+	an array of cache nodes and a size, with the same conditions as
+	createCacheSystem, and returns a pointer to the cache system, or NULL if
+	any condition is failed.
+*/
+cacheSystem_t* createDirectorySystem(cacheNode_t** caches, uint32_t size);
 
 /* 
 	Takes in a cache system and frees it and any memory any of its parts take
@@ -127,7 +187,46 @@ void deleteCacheSystem(cacheSystem_t* cacheSystem);
 	that is being stored in node with that ID number. If the ID number is not
 	valid for the cache system then it returns a NULL pointer.
 */
-cache_t* getCacheFromID(cacheSystem_t* cacheSystem, uint8_t ID);
+cache_t* getCacheFromID(cacheSystem_t* cacheSystem, uint16_t ID);
+
+/*
+	Takes in a cache system and an address and returns the snooper that tracks
+	the block of the address: the snooper of the system, or with DIRECTORY the
+	directory of the home of the block.
+*/
+snoopy_t* homeSnooper(cacheSystem_t* cacheSystem, uint32_t address);
+
+/*
+	Takes in a cache system and counts a request of one of its caches, which is
+	broadcast to every other cache or sent to the home of the block.
+*/
+void countRequest(cacheSystem_t* cacheSystem);
+
+/*
+	Takes in a cache system and counts a request passed on to a cache that holds
+	the block. Only a directory sends it as a message, as every cache sees a
+	broadcast request.
+*/
+void countForward(cacheSystem_t* cacheSystem);
+
+/*
+	Takes in a cache system and a number of caches and counts an invalidation
+	of each of them. Only a directory sends the invalidations and their acks as
+	messages.
+*/
+void countInvalidations(cacheSystem_t* cacheSystem, uint32_t count);
+
+/*
+	Takes in a cache system and counts a block sent to or from a cache.
+*/
+void countData(cacheSystem_t* cacheSystem);
+
+/*
+	Takes in a cache system and counts a cache dropping a block, which only a
+	directory has to learn of. Under snooping a clean block is dropped
+	silently and a dirty one only costs its writeback.
+*/
+void countEviction(cacheSystem_t* cacheSystem);
 
 /*
 	Takes in a cache and an address and determines the state of the block
@@ -152,7 +251,7 @@ void setState(cache_t* cache, uint32_t blockNumber, enum state newState);
 void updateState(cache_t* cache, uint32_t address, enum state otherState);
 
 /*
-	Creates a new snooper with 8 buckets.
+	Creates a new snooper with SNOOPER_SLOTS slots.
 */
 snoopy_t* createSnooper();
 
@@ -161,40 +260,40 @@ snoopy_t* createSnooper();
 */
 void deleteSnooper(snoopy_t* snooper);
 
-/*
-	Creates a bucket for the snooper.
-*/
-snoopBucket_t* createBucket();
-
-/*
-	Creates a new list to keep track of IDs and addresses.
-*/
-addressList_t* createList(uint32_t address, uint8_t ID, addressList_t* next);
-
 /*
 	Hash function used to place addresses in a snooper.
 */
 uint32_t hash(uint32_t address);
 
 /*
-	Adds a new list to the snooper. If a list with the same address and ID is already
-	there it does nothing. Otherwise it finds its appropriate bucket for that address and
-	appends it to the front of our list. If capacity becomes twice the number of buckets
-	the number of buckets should shift.
+	Adds a new entry to the snooper. If an entry with the same address and ID is
+	already there it does nothing. Otherwise the ID is set in the sharer vector
+	of the address, which takes the first free slot from the hash of the address
+	if no cache held it. If half of the slots become used the snooper starts to
+	resize.
 */
-void addToSnooper(snoopy_t* snooper, uint32_t address, uint8_t ID, uint32_t blockDataSize);
+void addToSnooper(snoopy_t* snooper, uint32_t address, uint16_t ID, uint32_t blockDataSize);
 
 /*
 	Takes in a snooper, an address, and an ID. Returns true if the snooper
-	contains a list containing the address and ID.	
+	contains an entry with the address and ID.
 */
-bool snooperContains(snoopy_t* snooper, uint32_t address, uint8_t ID);
+bool snooperContains(snoopy_t* snooper, uint32_t address, uint16_t ID);
 
 /*
-	Resizes the snooper if the load factor becomes >= 2.
+	Starts to move the snooper to a table with twice as many slots, first
+	finishing any resize still under way. Called when half of the slots
+	are used.
 */
 void resizeSnooper(snoopy_t* snooper);
 
+/*
+	Moves the entries of the next SNOOPER_MIGRATE_STEP slots of the old
+	table of a snooper that is resizing and frees the old table once
+	every slot has moved. Does nothing if no resize is under way.
+*/
+void migrateSnooper(snoopy_t* snooper);
+
 /*
 	Takes in a snooper, address, and block size and returns the ID of the cache
 	 that contains the info if it is the sole cache. Otherwise it returns -1.
@@ -202,27 +301,36 @@ void resizeSnooper(snoopy_t* snooper);
 int returnIDIf1(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize);
 
 /*
-	Takes in a snooper, an address, and a blocksize and returns the first 
-	cache to contain the address. Returns -1 if there are none.
-*/ 
+	Takes in a snooper, an address, and a blocksize and returns the cache with
+	the lowest ID that contains the address. Returns -1 if there are none.
+*/
 int returnFirstCacheID(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize);
 
 /*
-	Takes in an address and an ID and removes that list content from the table.
-	If the contents are not in the table it does nothing.
+	Takes in a snooper, an address, a blocksize, and an ID or -1 and returns
+	the cache with the lowest ID above it that contains the address. Returns
+	-1 if there are none.
+*/
+int returnNextCacheID(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize, int ID);
+
+/*
+	Takes in an address and an ID and removes that entry from the table.
+	If the entry is not in the table it does nothing.
 */
-void removeFromSnooper(snoopy_t* snooper, uint32_t address, uint8_t ID, uint32_t blockDataSize);
+void removeFromSnooper(snoopy_t* snooper, uint32_t address, uint16_t ID, uint32_t blockDataSize);
 
 /*
-	Takes in a pointer to a pointer to a list, an address, and an ID and removes
-	the list element from the list that matches the ID. If no element matches
-	it does nothing.
+	Takes in a snooper, an address, and a blocksize and removes the address
+	from every cache that holds it in one step, as when a write invalidates
+	all of them. If no cache holds the address it does nothing.
 */
-void removeItem(addressList_t** lst, uint32_t address, uint8_t ID);
+void removeAllFromSnooper(snoopy_t* snooper, uint32_t address, uint32_t blockDataSize);
 
 /*
-	Decrements the LRU of every block by 1 except for the block that just
-	got invalidated which is set to the LRU max value.
+	Updates the replacement state of the set after the given block just got
+	invalidated. For LRU the block is set to the LRU max value and every
+	valid block older than it is decremented by 1, and other policies
+	usually make the block the next victim of its set.
 */
-void decrementLRU(cache_t* cache, uint32_t tag, uint32_t idx, long oldLRU);
+void decrementLRU(cache_t* cache, uint32_t blockNumber);
 #endif
\ No newline at end of file
@@ -14,52 +14,67 @@
 	of data, and a pointer to data and calls the appropriate functions on the
 	cache being selected to write to the cache.
 */
-void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint8_t size, uint8_t* data) {
+void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint8_t size, uint8_t* data) {
 	uint8_t* transferData;
 	evictionInfo_t* dstCacheInfo;
 	evictionInfo_t* otherCacheInfo = NULL;
 	uint32_t evictionBlockNumber;
 	uint32_t offset;
-	cacheNode_t** caches;
 	//uint32_t tagVal;
 	int otherCacheContains = 0;
 	cache_t* dstCache = NULL;
-	uint8_t counter = 0;
-	caches = cacheSystem->caches;
-	while (dstCache == NULL && counter < cacheSystem->size) { //Selects destination cache pointer from array of caches pointers
-		if (caches[counter]->ID == ID) {
-			dstCache = caches[counter]->cache;
-		}
-		counter++;
-	}
+	snoopy_t* home = homeSnooper(cacheSystem, address);
+	uint32_t invalidated = 0;
+	bool forwarded = false;
+	dstCache = getCacheFromID(cacheSystem, ID); //Selects destination cache pointer from the index of the system
 	dstCacheInfo = findEviction(dstCache, address); //Finds block to evict and potential match
 	evictionBlockNumber = dstCacheInfo->blockNumber;
 	offset = getOffset(dstCache, address);
 	if (dstCacheInfo->match) {
 		/*What do you do if it is in the cache?*/
 		writeToCache(dstCache, address, data, size); // WRITE TO IT
-		if (returnFirstCacheID(cacheSystem->snooper, address, cacheSystem->blockDataSize) != -1) {
+		if (returnFirstCacheID(home, address, cacheSystem->blockDataSize) != -1) {
 			otherCacheContains = 1;
 		}
 	} else {
 		uint32_t oldAddress = extractAddress(dstCache, extractTag(dstCache, evictionBlockNumber), evictionBlockNumber, 0);
+		snoopy_t* oldHome = homeSnooper(cacheSystem, oldAddress);
+		bool valid = getValid(dstCache, evictionBlockNumber);		// An invalid block holds no address to drop
+		bool evicted = valid && snooperContains(oldHome, oldAddress, ID);
+		if (evicted) {
+			countEviction(cacheSystem);
+			if (getDirty(dstCache, evictionBlockNumber)) {
+				countData(cacheSystem);		// The block is written back
+			}
+		}
 		/*How do you need to update the snooper?*/
 		/*How do you need to update states for what is getting evicted (don't worry about evicting this will be handled at a later step when you place data in the cache)?*/
-		removeFromSnooper(cacheSystem->snooper, oldAddress, ID, size);	// Not necessary to keep track anymore
+		if (valid) {
+			removeFromSnooper(oldHome, oldAddress, ID, size);	// Not necessary to keep track anymore
+		}
 
-		int otherID = returnIDIf1(cacheSystem->snooper, oldAddress, cacheSystem->blockDataSize);
+		int otherID = evicted ? returnIDIf1(oldHome, oldAddress, cacheSystem->blockDataSize) : -1;
 		if (otherID != -1) { // If the other block is the only one that had the oldAddr
 			setState(dstCache, evictionBlockNumber, INVALID); // ----
 		}
 
-		int val = returnFirstCacheID(cacheSystem->snooper, address, cacheSystem->blockDataSize);
+		int val = returnFirstCacheID(home, address, cacheSystem->blockDataSize);
+		if (val == ID) {		// The writer missed, so an entry of its own is stale
+			removeFromSnooper(home, address, ID, cacheSystem->blockDataSize);
+			val = returnFirstCacheID(home, address, cacheSystem->blockDataSize);
+		}
+		countRequest(cacheSystem);
+		countData(cacheSystem);		// From the holder or from memory
 		/*Check other caches???*/
 		/*Your Code Here*/
 		if (val != -1) { // ProbeWrite
 			otherCacheContains = 1;
+			forwarded = true;
+			countForward(cacheSystem);
 			otherCacheInfo = findEviction(getCacheFromID(cacheSystem, val), address);
 			transferData = fetchBlock(getCacheFromID(cacheSystem, val), otherCacheInfo->blockNumber);	// Fetch the whole block
 			writeWholeBlock(dstCache, address, evictionBlockNumber, transferData);
+			writeToCache(dstCache, address, data, size);
 			free(transferData);
 			free(otherCacheInfo);
 		}
@@ -76,17 +91,22 @@ void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID,
 	if (otherCacheContains) {
 		/*What states need to be updated?*/
 		/*Does anything else need to be editted?*/
-		int removeID = returnFirstCacheID(cacheSystem->snooper, address, cacheSystem->blockDataSize);
+		int removeID = returnFirstCacheID(home, address, cacheSystem->blockDataSize);
 		while (removeID != -1) {
 			otherCacheInfo = findEviction(getCacheFromID(cacheSystem, removeID), address);
 			setState(getCacheFromID(cacheSystem, removeID), otherCacheInfo->blockNumber, INVALID);
-			removeFromSnooper(cacheSystem->snooper, address, removeID, cacheSystem->blockDataSize);
-			removeID = returnFirstCacheID(cacheSystem->snooper, address, cacheSystem->blockDataSize);
+			invalidated += removeID != ID;
+			removeID = returnNextCacheID(home, address, cacheSystem->blockDataSize, removeID);
 			free(otherCacheInfo);
 		}
+		removeAllFromSnooper(home, address, cacheSystem->blockDataSize);
+		if (dstCacheInfo->match && invalidated > 0) {
+			countRequest(cacheSystem);		// Upgrade
+		}
+		countInvalidations(cacheSystem, invalidated - forwarded);	// The forwarded holder drops its own copy
 	}
 	setState(dstCache, evictionBlockNumber, MODIFIED);	// SET TO MODIFIED
-	addToSnooper(cacheSystem->snooper, address, ID, cacheSystem->blockDataSize);
+	addToSnooper(home, address, ID, cacheSystem->blockDataSize);
 
 	free(dstCacheInfo);
 }
@@ -97,7 +117,7 @@ void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID,
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemByteWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint8_t data) {
+int cacheSystemByteWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint8_t data) {
 	/* Error Checking??*/
 	if (cacheSystem == NULL || validAddresses(address, (uint32_t) 1) != 1 || (address % 1 != 0) || getCacheFromID(cacheSystem, ID) == NULL) {
 		return -1;
@@ -114,7 +134,7 @@ int cacheSystemByteWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemHalfWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint16_t data) {
+int cacheSystemHalfWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint16_t data) {
 	/* Error Checking??*/
 	if (cacheSystem == NULL || validAddresses(address, (uint32_t) 2) != 1 || (address % 2) != 0 || getCacheFromID(cacheSystem, ID) == NULL) {
 		return -1;
@@ -136,7 +156,7 @@ int cacheSystemHalfWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint32_t data) {
+int cacheSystemWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint32_t data) {
 	/* Error Checking??*/
 	if (cacheSystem == NULL || validAddresses(address, (uint32_t) 4) != 1 || (address % 4 != 0) || getCacheFromID(cacheSystem, ID) == NULL) {
 		return -1;
@@ -160,7 +180,7 @@ int cacheSystemWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemDoubleWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint64_t data) {
+int cacheSystemDoubleWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint64_t data) {
 	/* Error Checking??*/
 	if (cacheSystem == NULL || validAddresses(address, (uint32_t) 8) != 1 || (address % 8 != 0) || getCacheFromID(cacheSystem, ID) == NULL) {
 		return -1;
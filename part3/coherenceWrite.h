@@ -8,7 +8,7 @@
 	of data, and a pointer to data and calls the appropriate functions on the 
 	cache being selected to write to the cache.
 */
-void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint8_t size, uint8_t* data);
+void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint8_t size, uint8_t* data);
 
 /*
 	A function used to write a byte to a specific cache in a cache system.
@@ -16,7 +16,7 @@ void cacheSystemWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID,
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemByteWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint8_t data);
+int cacheSystemByteWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint8_t data);
 
 /*
 	A function used to write a halfword to a specific cache in a cache system.
@@ -24,7 +24,7 @@ int cacheSystemByteWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemHalfWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint16_t data);
+int cacheSystemHalfWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint16_t data);
 
 /*
 	A function used to write a word to a specific cache in a cache system.
@@ -32,7 +32,7 @@ int cacheSystemHalfWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint32_t data);
+int cacheSystemWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint32_t data);
 
 /*
 	A function used to write a doubleword to a specific cache in a cache system.
@@ -40,5 +40,5 @@ int cacheSystemWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t I
 	will be written to. Returns 0 if the write is successful and otherwise
 	returns -1.
 */
-int cacheSystemDoubleWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint8_t ID, uint64_t data);
+int cacheSystemDoubleWordWrite(cacheSystem_t* cacheSystem, uint32_t address, uint16_t ID, uint64_t data);
 #endif
\ No newline at end of file
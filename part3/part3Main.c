@@ -14,6 +14,7 @@ int main() {
 	uint32_t blockDataSize;
 	uint32_t totalDataSize;
 	char* memFile;
+	physicalMemory_t* memory;
 	cacheSystem_t* sys;
 	cacheNode_t** lst;
 	byteInfo_t byteVal;
@@ -29,11 +30,13 @@ int main() {
 	totalDataSize = 1024;
 	memFile = "testFiles/physicalMemory2.txt";
 	lst = malloc(sizeof(cacheNode_t*) * 2);
-	cache = createCache(n, blockDataSize, totalDataSize, memFile);
+	memory = openPhysicalMemory(memFile);
+	cache = createCacheFromMemory(n, blockDataSize, totalDataSize, memory);
 	lst[0] = createCacheNode(cache, 1);
-	cache = createCache(n, blockDataSize, totalDataSize, memFile);
+	cache = createCacheFromMemory(n, blockDataSize, totalDataSize, memory);
 	lst[1] = createCacheNode(cache, 2);
 	sys = createCacheSystem(lst, 2, createSnooper());
+	releasePhysicalMemory(memory);
 	//Create a two cache system
 	for (unsigned int i = 0; i < 72; i++) {
 		if (i & 1) {
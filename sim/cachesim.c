@@ -0,0 +1,481 @@
+/* Summer 2017 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "../part1/cacheBatch.h"
+#include "../part1/replacement.h"
+#include "../part2/hitRate.h"
+#include "../part2/stackDistance.h"
+#include "trace.h"
+#include "optimal.h"
+#include "sweep.h"
+
+/*
+	Number of accesses read from the trace and passed to the cache at once.
+*/
+#define BATCH_SIZE 4096
+
+/*
+	Most values a list given to -n, -b, -t, or -r can hold with -g.
+*/
+#define MAX_LIST_VALUES 32
+
+/*
+	Prints how the simulator is used.
+*/
+static void usage(char* program) {
+	fprintf(stderr, "usage: %s [-n ways] [-b blockBytes] [-t totalBytes] [-m memoryFile] [-s size] [-r policy] [-p ratio] [-f] [-c [-S rate] [-e]] [-g [-j threads]] [-o binaryTrace] trace\n", program);
+	fprintf(stderr, "  -n  associativity (default 4)\n");
+	fprintf(stderr, "  -b  block size in bytes (default 64)\n");
+	fprintf(stderr, "  -t  total data size in bytes (default 32768)\n");
+	fprintf(stderr, "  -m  initial physical memory, left unchanged (default all zeros)\n");
+	fprintf(stderr, "  -s  size in bytes of the read made for bare addresses (default 1)\n");
+	fprintf(stderr, "  -r  replacement policy: lru, plru, srrip, brrip, drrip, fifo, random, lfu, clock, nru, or opt (default lru)\n");
+	fprintf(stderr, "  -p  simulate one set in every ratio, a power of 2, and estimate the hit rate (default 1)\n");
+	fprintf(stderr, "  -f  use the fast cache layout\n");
+	fprintf(stderr, "  -c  print the LRU miss ratio of every cache up to -t bytes with -b byte blocks\n");
+	fprintf(stderr, "  -S  with -c, sample this fraction of the blocks of the trace (default 1)\n");
+	fprintf(stderr, "  -e  with -S, also find the exact curve and print the error of the sampled one\n");
+	fprintf(stderr, "  -g  sweep every combination of the comma separated lists given to -n, -b, -t, and -r\n");
+	fprintf(stderr, "  -j  with -g, threads to run on (default the number of cores)\n");
+	fprintf(stderr, "  -o  convert the trace to the binary format instead of simulating it\n");
+}
+
+/*
+	Takes in a string and a pointer to a value and parses the string as a
+	positive number. Returns false if it is not one.
+*/
+static bool parseOption(char* text, uint32_t* value) {
+	char* end;
+	unsigned long result = strtoul(text, &end, 0);
+	if (*text == '\0' || *end != '\0' || result == 0 || result > UINT32_MAX) {
+		return false;
+	}
+	*value = (uint32_t) result;
+	return true;
+}
+
+/*
+	Takes in a comma separated string and an array of MAX_LIST_VALUES
+	values and parses every item of the string as a positive number.
+	Returns the number of values or 0 if an item is not one or there are
+	too many.
+*/
+static uint32_t parseList(char* text, uint32_t* values) {
+	uint32_t count = 0;
+	char* state;
+	for (char* item = strtok_r(text, ",", &state); item != NULL; item = strtok_r(NULL, ",", &state)) {
+		if (count == MAX_LIST_VALUES || !parseOption(item, &values[count++])) {
+			return 0;
+		}
+	}
+	return count;
+}
+
+/*
+	Takes in a comma separated string and an array of MAX_LIST_VALUES
+	policies and finds the policy named by every item of the string.
+	Returns the number of policies or 0 if an item names none or there are
+	too many.
+*/
+static uint32_t parsePolicies(char* text, enum replacementPolicy* policies) {
+	uint32_t count = 0;
+	char* state;
+	for (char* item = strtok_r(text, ",", &state); item != NULL; item = strtok_r(NULL, ",", &state)) {
+		if (count == MAX_LIST_VALUES || !findPolicy(item, &policies[count++])) {
+			return 0;
+		}
+	}
+	return count;
+}
+
+/*
+	Takes in a string and a pointer to a rate and parses the string as a
+	number above 0 and at most 1. Returns false if it is not one.
+*/
+static bool parseRate(char* text, double* rate) {
+	char* end;
+	double result = strtod(text, &end);
+	if (*text == '\0' || *end != '\0' || !(result > 0 && result <= 1)) {
+		return false;
+	}
+	*rate = result;
+	return true;
+}
+
+/*
+	Returns the current time in seconds from a monotonic clock.
+*/
+static double now() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*
+	Takes in the name of a trace, the size of the read made for bare
+	addresses, a block size, a total data size, a sampling rate, and
+	whether to compare against the exact curve and prints the miss ratio
+	of every LRU cache with that block size and at most that much data,
+	found from the stack distances of a single pass over the trace. With a
+	rate below 1 only that fraction of the blocks is tracked, and with
+	compare an exact tracker is fed in the same pass so the error of every
+	sampled miss ratio is printed too. Returns 0 for a success and 1 if the
+	trace cannot be read.
+*/
+static int printCurve(char* name, uint32_t size, uint32_t blockDataSize, uint32_t maxDataSize, double rate,
+	bool compare) {
+	stackDistance_t* tracker = createSampledStackDistance(blockDataSize, maxDataSize, rate);
+	stackDistance_t* exact = compare ? createStackDistance(blockDataSize, maxDataSize) : NULL;
+	if (tracker == NULL) {
+		fprintf(stderr, "Error: -b and -t must be powers of 2 with -b <= -t <= %u\n", MEMORY_SIZE);
+		return 1;
+	}
+	traceReader_t* trace = openTrace(name, size);
+	if (trace == NULL) {
+		fprintf(stderr, "Error: cannot open trace %s\n", name);
+		deleteStackDistance(tracker);
+		if (exact != NULL) {
+			deleteStackDistance(exact);
+		}
+		return 1;
+	}
+	cacheRequest_t* requests = malloc(sizeof(cacheRequest_t) * BATCH_SIZE);
+	if (requests == NULL) {
+		allocationFailed();
+	}
+	uint32_t count;
+	double start = now();
+	while ((count = readTrace(trace, requests, BATCH_SIZE)) > 0) {
+		recordRequests(tracker, requests, count);
+	}
+	double elapsed = now() - start;
+	if (exact != NULL) {
+		// The exact tracker is timed apart so wall time stays that of the sampled one
+		closeTrace(trace);
+		trace = openTrace(name, size);
+		while (trace != NULL && (count = readTrace(trace, requests, BATCH_SIZE)) > 0) {
+			recordRequests(exact, requests, count);
+		}
+	}
+	bool failed = trace == NULL || trace->failed;
+
+	printf("trace:       %s\n", name);
+	printf("accesses:    %" PRIu64 "\n", tracker->accesses);
+	printf("sampled:     %" PRIu64 " (rate %.6f)\n", tracker->sampled,
+		(double) tracker->sampleThreshold / SAMPLE_MODULUS);
+	printf("wall time:   %.6f s\n", elapsed);
+	printf("%10s %8s %8s %10s", "bytes", "ways", "sets", "miss rate");
+	if (exact != NULL) {
+		printf(" %10s %10s", "exact", "error");
+	}
+	printf("\n");
+	double totalError = 0;
+	double maxError = 0;
+	uint32_t points = 0;
+	for (uint32_t totalDataSize = blockDataSize; totalDataSize <= maxDataSize; totalDataSize <<= 1) {
+		for (uint32_t n = 1; n * blockDataSize <= totalDataSize; n <<= 1) {
+			double missRate = 1 - stackHitRate(tracker, n, totalDataSize);
+			printf("%10u %8u %8u %10.6f", totalDataSize, n, totalDataSize / blockDataSize / n, missRate);
+			if (exact != NULL) {
+				double exactRate = 1 - stackHitRate(exact, n, totalDataSize);
+				double error = missRate > exactRate ? missRate - exactRate : exactRate - missRate;
+				totalError += error;
+				maxError = error > maxError ? error : maxError;
+				points++;
+				printf(" %10.6f %10.6f", exactRate, error);
+			}
+			printf("\n");
+		}
+	}
+	if (exact != NULL) {
+		printf("mean error:  %.6f\n", points > 0 ? totalError / points : 0.0);
+		printf("max error:   %.6f\n", maxError);
+		deleteStackDistance(exact);
+	}
+	free(requests);
+	if (trace != NULL) {
+		closeTrace(trace);
+	}
+	deleteStackDistance(tracker);
+	return failed ? 1 : 0;
+}
+
+/*
+	Takes in the name of a trace, the size of the read made for bare
+	addresses, the name of the initial memory or NULL, the lists of
+	associativities, block sizes, total sizes, and policies, and a number
+	of threads and prints the hit rate of every combination of them. The
+	trace is decoded once and the caches are simulated in parallel.
+	Combinations that are not valid caches are printed without a hit rate.
+	Misses are split into compulsory, capacity, and conflict misses, each
+	given as a fraction of the accesses.
+	Returns 0 for a success and 1 if a list or the trace cannot be read.
+*/
+static int printSweep(char* name, uint32_t size, char* memoryName, char* waysList, char* blockList,
+	char* totalList, char* policyList, uint32_t threads) {
+	uint32_t ways[MAX_LIST_VALUES];
+	uint32_t blocks[MAX_LIST_VALUES];
+	uint32_t totals[MAX_LIST_VALUES];
+	enum replacementPolicy policies[MAX_LIST_VALUES];
+	uint32_t numWays = parseList(waysList, ways);
+	uint32_t numBlocks = parseList(blockList, blocks);
+	uint32_t numTotals = parseList(totalList, totals);
+	uint32_t numPolicies = parsePolicies(policyList, policies);
+	if (numWays == 0 || numBlocks == 0 || numTotals == 0 || numPolicies == 0) {
+		fprintf(stderr, "Error: -n, -b, -t, and -r take up to %u comma separated values\n", MAX_LIST_VALUES);
+		return 1;
+	}
+	physicalMemory_t* memory = openPrivatePhysicalMemory(memoryName);
+	if (memory == NULL) {
+		physicalMemFailed();
+		return 1;
+	}
+	sweepTrace_t* trace = loadSweepTrace(name, size);
+	if (trace == NULL) {
+		fprintf(stderr, "Error: cannot read trace %s\n", name);
+		releasePhysicalMemory(memory);
+		return 1;
+	}
+	uint32_t count = numWays * numBlocks * numTotals * numPolicies;
+	sweepConfig_t* configs = malloc(sizeof(sweepConfig_t) * count);
+	if (configs == NULL) {
+		allocationFailed();
+	}
+	uint32_t index = 0;
+	for (uint32_t t = 0; t < numTotals; t++) {
+		for (uint32_t b = 0; b < numBlocks; b++) {
+			for (uint32_t w = 0; w < numWays; w++) {
+				for (uint32_t p = 0; p < numPolicies; p++) {
+					configs[index].n = ways[w];
+					configs[index].blockDataSize = blocks[b];
+					configs[index].totalDataSize = totals[t];
+					configs[index].policy = policies[p];
+					index++;
+				}
+			}
+		}
+	}
+	double start = now();
+	runSweep(trace, memory, configs, count, threads);
+	double elapsed = now() - start;
+
+	printf("trace:       %s\n", name);
+	printf("records:     %" PRIu64 "\n", trace->count);
+	printf("caches:      %u on %u threads\n", count, threads < count ? threads : count);
+	printf("wall time:   %.6f s\n", elapsed);
+	printf("%10s %8s %10s %8s %12s %10s %10s %10s %10s\n", "bytes", "ways", "block", "policy", "accesses", "hit rate",
+		"compulsory", "capacity", "conflict");
+	for (uint32_t i = 0; i < count; i++) {
+		printf("%10u %8u %10u %8s", configs[i].totalDataSize, configs[i].n, configs[i].blockDataSize,
+			policyEngine(configs[i].policy)->name);
+		if (configs[i].valid) {
+			double access = configs[i].access > 0 ? configs[i].access : 1;
+			printf(" %12.0f %10.6f %10.6f %10.6f %10.6f\n", configs[i].access, configs[i].hit / access,
+				configs[i].compulsory / access, configs[i].capacity / access, configs[i].conflict / access);
+		} else {
+			printf(" %12s %10s\n", "-", "invalid");
+		}
+	}
+	free(configs);
+	deleteSweepTrace(trace);
+	releasePhysicalMemory(memory);
+	return 0;
+}
+
+/*
+	Streams a trace through a cache configured from the command line and
+	reports the hit rate, the wall time, and the number of accesses
+	simulated per second. The trace is read in fixed size batches so any
+	length of trace runs in the same memory. With -o the trace is instead
+	converted to the binary format, which replays without parsing text.
+	With -r opt the trace is scanned once before it is replayed, since OPT
+	needs to know when every block is used next. With -c no cache is
+	simulated and the miss ratio curve of the trace is printed instead,
+	which -S estimates from a sample of the blocks for long traces. With -p
+	only a sample of the sets is simulated and the hit rate is estimated.
+	With -g every combination of the lists given to -n, -b, -t, and -r is
+	simulated on a pool of threads.
+*/
+int main(int argc, char** argv) {
+	uint32_t n;
+	uint32_t blockDataSize;
+	uint32_t totalDataSize;
+	uint32_t size = 1;
+	char* waysText = "4";
+	char* blockText = "64";
+	char* totalText = "32768";
+	char* policyText = "lru";
+	bool sweep = false;
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	uint32_t threads = cores > 0 ? (uint32_t) cores : 1;
+	char* memoryName = NULL;
+	char* outputName = NULL;
+	bool curve = false;
+	bool compare = false;
+	double rate = 1;
+	cacheOptions_t options = defaultCacheOptions();
+	options.classifyMisses = true;
+	int option;
+	bool valid = true;
+	while ((option = getopt(argc, argv, "n:b:t:m:s:r:p:fcS:egj:o:")) != -1) {
+		switch (option) {
+			case 'n':
+				waysText = optarg;
+				break;
+			case 'b':
+				blockText = optarg;
+				break;
+			case 't':
+				totalText = optarg;
+				break;
+			case 's':
+				valid &= parseOption(optarg, &size);
+				break;
+			case 'm':
+				memoryName = optarg;
+				break;
+			case 'r':
+				policyText = optarg;
+				break;
+			case 'p':
+				valid &= parseOption(optarg, &options.sampleRatio);
+				break;
+			case 'f':
+				options.layout = FAST_LAYOUT;
+				break;
+			case 'c':
+				curve = true;
+				break;
+			case 'S':
+				valid &= parseRate(optarg, &rate);
+				break;
+			case 'e':
+				compare = true;
+				break;
+			case 'g':
+				sweep = true;
+				break;
+			case 'j':
+				valid &= parseOption(optarg, &threads);
+				break;
+			case 'o':
+				outputName = optarg;
+				break;
+			default:
+				valid = false;
+				break;
+		}
+	}
+	if (!valid || optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (sweep) {
+		return printSweep(argv[optind], size, memoryName, waysText, blockText, totalText, policyText, threads);
+	}
+	if (!parseOption(waysText, &n) || !parseOption(blockText, &blockDataSize)
+		|| !parseOption(totalText, &totalDataSize) || !findPolicy(policyText, &options.policy)) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (outputName != NULL) {
+		traceReader_t* trace = openTrace(argv[optind], size);
+		if (trace == NULL) {
+			fprintf(stderr, "Error: cannot open trace %s\n", argv[optind]);
+			return 1;
+		}
+		int64_t written = writeBinaryTrace(trace, outputName);
+		closeTrace(trace);
+		if (written == -1) {
+			fprintf(stderr, "Error: cannot write binary trace %s\n", outputName);
+			return 1;
+		}
+		printf("wrote %" PRId64 " records to %s\n", written, outputName);
+		return 0;
+	}
+
+	if (curve) {
+		return printCurve(argv[optind], size, blockDataSize, totalDataSize, rate, compare);
+	}
+
+	uint32_t* nextUses = NULL;
+	uint64_t uses = 0;
+	if (options.policy == OPT_POLICY) {
+		// OPT needs the future, so the trace is scanned once before it is replayed
+		nextUses = findNextUses(argv[optind], size, blockDataSize, &uses);
+		if (nextUses == NULL) {
+			fprintf(stderr, "Error: cannot scan trace %s\n", argv[optind]);
+			return 1;
+		}
+	}
+	physicalMemory_t* memory = openPrivatePhysicalMemory(memoryName);
+	if (memory == NULL) {
+		physicalMemFailed();
+		return 1;
+	}
+	cache_t* cache = createCacheWithOptions(n, blockDataSize, totalDataSize, memory, &options);
+	releasePhysicalMemory(memory);
+	if (cache == NULL) {
+		free(nextUses);
+		return 1;
+	}
+	setNextUses(cache, nextUses, uses);
+	traceReader_t* trace = openTrace(argv[optind], size);
+	if (trace == NULL) {
+		fprintf(stderr, "Error: cannot open trace %s\n", argv[optind]);
+		deleteCache(cache);
+		free(nextUses);
+		return 1;
+	}
+	cacheRequest_t* requests = malloc(sizeof(cacheRequest_t) * BATCH_SIZE);
+	cacheResult_t* results = malloc(sizeof(cacheResult_t) * BATCH_SIZE);
+	if (requests == NULL || results == NULL) {
+		allocationFailed();
+	}
+
+	uint64_t records = 0;
+	uint64_t performed = 0;
+	uint32_t count;
+	double start = now();
+	while ((count = readTrace(trace, requests, BATCH_SIZE)) > 0) {
+		performed += accessBatch(cache, requests, results, count);
+		records += count;
+	}
+	double elapsed = now() - start;
+	bool failed = trace->failed;
+
+	printf("trace:       %s\n", argv[optind]);
+	printf("cache:       %u ways, %u byte blocks, %u bytes, %s layout, %s\n", n, blockDataSize, totalDataSize,
+		options.layout == FAST_LAYOUT ? "fast" : "packed", cache->engine->name);
+	printf("records:     %" PRIu64 " (%" PRIu64 " invalid)\n", records, records - performed);
+	if (cache->sampledSets < getNumSets(cache)) {
+		printf("sampled:     %u of %u sets, %.0f accesses skipped\n", cache->sampledSets, getNumSets(cache),
+			cache->skipped);
+	}
+	printf("accesses:    %.0f\n", cache->access);
+	printf("hits:        %.0f\n", cache->hit);
+	printf("misses:      %.0f compulsory, %.0f capacity, %.0f conflict\n", cache->misses->compulsory,
+		cache->misses->capacity, cache->misses->conflict);
+	printf("hit rate:    %.6f", cache->access > 0 ? findHitRate(cache) : 0.0);
+	if (cache->sampledSets < getNumSets(cache)) {
+		printf(" +- %.6f (95%%)", hitRateMargin(cache));
+	}
+	printf("\n");
+	printf("wall time:   %.6f s\n", elapsed);
+	printf("throughput:  %.0f accesses/s\n", elapsed > 0 ? (cache->access + cache->skipped) / elapsed : 0.0);
+
+	free(requests);
+	free(results);
+	free(nextUses);
+	closeTrace(trace);
+	deleteCache(cache);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/* Summer 2017 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "../part3/coherenceUtils.h"
+#include "../part3/coherenceRead.h"
+#include "../part3/coherenceWrite.h"
+
+/*
+	Geometry of every cache of the systems measured.
+*/
+#define BENCH_WAYS 2
+#define BENCH_BLOCK_SIZE 16
+#define BENCH_TOTAL_SIZE 256
+
+/*
+	Smallest and largest number of caches of the systems measured.
+*/
+#define BENCH_MIN_CACHES 2
+#define BENCH_MAX_CACHES 256
+
+/*
+	Bytes of memory only one cache uses, and of memory every cache shares.
+*/
+#define BENCH_PRIVATE_SIZE 1024
+#define BENCH_SHARED_SIZE 1024
+
+/*
+	Prints how the benchmark is used.
+*/
+static void usage(char* program) {
+	fprintf(stderr, "usage: %s [-a accesses] [-s sharedPercent] [-w writePercent]\n", program);
+	fprintf(stderr, "  -a  accesses made by every cache (default 2000)\n");
+	fprintf(stderr, "  -s  percent of the accesses to shared memory (default 20)\n");
+	fprintf(stderr, "  -w  percent of the accesses that are writes (default 30)\n");
+}
+
+/*
+	Takes in a string, a pointer to a value, and a maximum and parses the
+	string as a number up to the maximum. Returns false if it is not one.
+*/
+static bool parseOption(char* text, uint32_t* value, uint32_t maximum) {
+	char* end;
+	unsigned long result = strtoul(text, &end, 0);
+	if (*text == '\0' || *end != '\0' || result > maximum) {
+		return false;
+	}
+	*value = (uint32_t) result;
+	return true;
+}
+
+/*
+	Takes in a number of caches, a mode, a number of accesses for every cache,
+	and the percents of shared accesses and of writes and runs the same random
+	accesses on a new system of that many caches kept coherent in that mode.
+	Returns the traffic of the system.
+*/
+static coherenceTraffic_t runSystem(uint32_t caches, enum coherenceMode mode, uint32_t accesses,
+	uint32_t shared, uint32_t writes) {
+	physicalMemory_t* memory = openPrivatePhysicalMemory(NULL);
+	cacheNode_t** lst = malloc(sizeof(cacheNode_t*) * caches);
+	if (lst == NULL) {
+		allocationFailed();
+	}
+	for (uint32_t i = 0; i < caches; i++) {
+		lst[i] = createCacheNode(createCacheFromMemory(BENCH_WAYS, BENCH_BLOCK_SIZE, BENCH_TOTAL_SIZE, memory), i);
+	}
+	cacheSystem_t* sys = mode == SNOOPING ? createCacheSystem(lst, caches, createSnooper()) : createDirectorySystem(lst, caches);
+	releasePhysicalMemory(memory);
+	srand(61);
+	for (uint64_t i = 0; i < (uint64_t) accesses * caches; i++) {
+		uint16_t ID = rand() % caches;
+		uint32_t address = MIN_ADDRESS;
+		if ((uint32_t) (rand() % 100) < shared) {
+			address += rand() % BENCH_SHARED_SIZE;
+		} else {
+			address += BENCH_SHARED_SIZE + ID * BENCH_PRIVATE_SIZE + rand() % BENCH_PRIVATE_SIZE;
+		}
+		address &= ~UINT32_C(3);
+		if ((uint32_t) (rand() % 100) < writes) {
+			cacheSystemWordWrite(sys, address, ID, (uint32_t) i);
+		} else {
+			cacheSystemWordRead(sys, address, ID);
+		}
+	}
+	coherenceTraffic_t traffic = sys->traffic;
+	deleteCacheSystem(sys);
+	return traffic;
+}
+
+/*
+	Runs the same accesses on systems of more and more caches kept coherent
+	by snooping and by a directory and prints the coherence traffic of each,
+	so the growth of broadcasts can be compared with that of point to point
+	messages.
+*/
+int main(int argc, char** argv) {
+	uint32_t accesses = 2000;
+	uint32_t shared = 20;
+	uint32_t writes = 30;
+	int option;
+	while ((option = getopt(argc, argv, "a:s:w:")) != -1) {
+		switch (option) {
+			case 'a':
+				if (!parseOption(optarg, &accesses, UINT32_MAX) || accesses == 0) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 's':
+				if (!parseOption(optarg, &shared, 100)) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 'w':
+				if (!parseOption(optarg, &writes, 100)) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc) {
+		usage(argv[0]);
+		return 1;
+	}
+	printf("%6s %-9s %10s %10s %10s %10s %10s %10s %12s %9s\n", "caches", "mode", "requests", "forwards",
+		"invals", "acks", "data", "evictions", "messages", "per acc");
+	for (uint32_t caches = BENCH_MIN_CACHES; caches <= BENCH_MAX_CACHES; caches <<= 1) {
+		for (int mode = SNOOPING; mode <= DIRECTORY; mode++) {
+			coherenceTraffic_t traffic = runSystem(caches, mode, accesses, shared, writes);
+			printf("%6" PRIu32 " %-9s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+				" %10" PRIu64 " %12" PRIu64 " %9.2f\n", caches, mode == SNOOPING ? "snooping" : "directory",
+				traffic.requests, traffic.forwards, traffic.invalidations, traffic.acks, traffic.data,
+				traffic.evictions, traffic.messages, (double) traffic.messages / ((double) accesses * caches));
+		}
+	}
+	return 0;
+}
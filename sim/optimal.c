@@ -0,0 +1,151 @@
+/* Summer 2017 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "../part1/cacheBatch.h"
+#include "../part1/replacement.h"
+#include "trace.h"
+#include "optimal.h"
+
+/*
+	Number of requests read from the trace at once while scanning it.
+*/
+#define SCAN_BATCH_SIZE 4096
+
+/*
+	Takes in an array of accesses, a pointer to its capacity, and the number
+	of accesses it holds and makes room for one more, doubling the capacity
+	when it is full. Returns the array, which may have moved, or NULL if it
+	cannot grow.
+*/
+static uint32_t* reserveAccess(uint32_t* accesses, uint64_t* capacity, uint64_t count) {
+	if (count < *capacity) {
+		return accesses;
+	}
+	uint64_t grown = *capacity > 0 ? *capacity * 2 : SCAN_BATCH_SIZE;
+	uint32_t* moved = realloc(accesses, grown * sizeof(uint32_t));
+	if (moved == NULL) {
+		free(accesses);
+		return NULL;
+	}
+	*capacity = grown;
+	return moved;
+}
+
+/*
+	Takes in an array of accesses, pointers to its capacity and to the number
+	of accesses it holds, a request, and a block size and appends the block
+	of every access accessBatch makes for the request, one for the request
+	or one for each block of a request wider than a block. Invalid requests
+	add nothing. Returns the array, which may have moved, or NULL if it
+	cannot grow or the next uses could no longer index it.
+*/
+static uint32_t* addRequest(uint32_t* accesses, uint64_t* capacity, uint64_t* total, cacheRequest_t* request,
+	uint32_t blockDataSize) {
+	if (!validRequest(request)) {
+		return accesses;
+	}
+	uint32_t blocks = request->size > blockDataSize ? request->size / blockDataSize : 1;
+	uint32_t block = (request->address - MIN_ADDRESS) / blockDataSize;
+	for (uint32_t j = 0; j < blocks; j++) {
+		accesses = reserveAccess(accesses, capacity, *total);
+		if (accesses == NULL || *total == OPT_NEVER) {
+			free(accesses);
+			return NULL;
+		}
+		accesses[(*total)++] = block + j;
+	}
+	return accesses;
+}
+
+/*
+	Takes in an array holding the block of every access, the number of
+	accesses, and a block size and replaces each block with the index of
+	the next access to it, or OPT_NEVER. Walks the accesses backwards,
+	keeping the last access seen to every block of memory.
+*/
+static void linkNextUses(uint32_t* accesses, uint64_t total, uint32_t blockDataSize) {
+	uint32_t* last = malloc(sizeof(uint32_t) * (MEMORY_SIZE / blockDataSize));
+	if (last == NULL) {
+		allocationFailed();
+	}
+	for (uint32_t i = 0; i < MEMORY_SIZE / blockDataSize; i++) {
+		last[i] = OPT_NEVER;
+	}
+	for (uint64_t i = total; i > 0; i--) {
+		uint32_t block = accesses[i - 1];
+		accesses[i - 1] = last[block];
+		last[block] = (uint32_t) (i - 1);
+	}
+	free(last);
+}
+
+/*
+	Takes in the name of a trace, the size of the read made for bare
+	addresses, the block size of the cache that will replay it, and a
+	pointer to a count and reads the whole trace once to find the next use
+	of every access the replay will make, in the form setNextUses takes.
+	Sets count to the number of accesses. Returns NULL if the trace cannot
+	be read or has more accesses than the next uses can index.
+
+	The first pass records the block of every access in the order
+	accessBatch makes them and the second links each to the next access
+	to its block. Both passes are linear and the only memory used is the
+	array itself and one entry per block of memory.
+*/
+uint32_t* findNextUses(char* name, uint32_t size, uint32_t blockDataSize, uint64_t* count) {
+	traceReader_t* trace = openTrace(name, size);
+	if (trace == NULL) {
+		return NULL;
+	}
+	cacheRequest_t* requests = malloc(sizeof(cacheRequest_t) * SCAN_BATCH_SIZE);
+	if (requests == NULL) {
+		allocationFailed();
+	}
+
+	uint64_t capacity = 0;
+	uint64_t total = 0;
+	uint32_t* accesses = reserveAccess(NULL, &capacity, total);
+	uint32_t read;
+	while (accesses != NULL && (read = readTrace(trace, requests, SCAN_BATCH_SIZE)) > 0) {
+		for (uint32_t i = 0; accesses != NULL && i < read; i++) {
+			accesses = addRequest(accesses, &capacity, &total, &requests[i], blockDataSize);
+		}
+	}
+	bool valid = accesses != NULL && !trace->failed;
+	closeTrace(trace);
+	free(requests);
+	if (!valid) {
+		free(accesses);
+		return NULL;
+	}
+	linkNextUses(accesses, total, blockDataSize);
+	*count = total;
+	return accesses;
+}
+
+/*
+	Takes in an array of requests already read from a trace, the number of
+	requests, the block size of the cache that will replay them, and a
+	pointer to a count and finds the next uses in the same way as
+	findNextUses. Returns NULL if there are more accesses than the next
+	uses can index.
+*/
+uint32_t* findRequestNextUses(cacheRequest_t* requests, uint64_t requestCount, uint32_t blockDataSize,
+	uint64_t* count) {
+	uint64_t capacity = 0;
+	uint64_t total = 0;
+	uint32_t* accesses = reserveAccess(NULL, &capacity, total);
+	for (uint64_t i = 0; accesses != NULL && i < requestCount; i++) {
+		accesses = addRequest(accesses, &capacity, &total, &requests[i], blockDataSize);
+	}
+	if (accesses == NULL) {
+		return NULL;
+	}
+	linkNextUses(accesses, total, blockDataSize);
+	*count = total;
+	return accesses;
+}
@@ -0,0 +1,24 @@
+/* Summer 2017 */
+#ifndef OPTIMAL_H
+#define OPTIMAL_H
+
+/*
+	Takes in the name of a trace, the size of the read made for bare
+	addresses, the block size of the cache that will replay it, and a
+	pointer to a count and reads the whole trace once to find the next use
+	of every access the replay will make, in the form setNextUses takes.
+	Sets count to the number of accesses. Returns NULL if the trace cannot
+	be read or has more accesses than the next uses can index.
+*/
+uint32_t* findNextUses(char* name, uint32_t size, uint32_t blockDataSize, uint64_t* count);
+
+/*
+	Takes in an array of requests already read from a trace, the number of
+	requests, the block size of the cache that will replay them, and a
+	pointer to a count and finds the next uses in the same way as
+	findNextUses. Returns NULL if there are more accesses than the next
+	uses can index.
+*/
+uint32_t* findRequestNextUses(cacheRequest_t* requests, uint64_t requestCount, uint32_t blockDataSize,
+	uint64_t* count);
+#endif
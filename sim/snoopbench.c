@@ -0,0 +1,154 @@
+/* Summer 2017 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include "../part1/utils.h"
+#include "../part3/coherenceUtils.h"
+
+/*
+	Block size of the addresses put in the snooper.
+*/
+#define BENCH_BLOCK_SIZE 64
+
+/*
+	Number of blocks held in the smallest and largest snooper measured.
+*/
+#define BENCH_MIN_BLOCKS (1 << 10)
+#define BENCH_MAX_BLOCKS (1 << 20)
+
+/*
+	Prints how the benchmark is used.
+*/
+static void usage(char* program) {
+	fprintf(stderr, "usage: %s [-c caches] [-s sharers] [-l lookups]\n", program);
+	fprintf(stderr, "  -c  number of caches in the system, at most 65536 (default 256)\n");
+	fprintf(stderr, "  -s  caches holding every block (default 2)\n");
+	fprintf(stderr, "  -l  lookups timed for every size (default 4000000)\n");
+}
+
+/*
+	Takes in a string and a pointer to a value and parses the string as a
+	positive number. Returns false if it is not one.
+*/
+static bool parseOption(char* text, uint32_t* value) {
+	char* end;
+	unsigned long result = strtoul(text, &end, 0);
+	if (*text == '\0' || *end != '\0' || result == 0 || result > UINT32_MAX) {
+		return false;
+	}
+	*value = (uint32_t) result;
+	return true;
+}
+
+/*
+	Returns the current time in seconds from a monotonic clock.
+*/
+static double now() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*
+	Takes in a block number and returns the address of the block.
+*/
+static uint32_t blockAddress(uint32_t block) {
+	return (block + 1) * BENCH_BLOCK_SIZE;
+}
+
+/*
+	Takes in a snooper holding blocks from block 0 up to blocks and returns
+	the mean number of slots probed to find one of them.
+*/
+static double meanProbes(snoopy_t* snooper, uint32_t blocks) {
+	uint64_t probes = 0;
+	uint64_t mask = snooper->numSlots - 1;
+	while (snooper->oldAddresses != NULL) {
+		migrateSnooper(snooper);
+	}
+	for (uint32_t i = 0; i < blocks; i++) {
+		uint64_t slot = hash(blockAddress(i)) & mask;
+		probes++;
+		while (snooper->addresses[slot] != blockAddress(i)) {
+			slot = (slot + 1) & mask;
+			probes++;
+		}
+	}
+	return (double) probes / blocks;
+}
+
+/*
+	Fills snoopers with more and more blocks, each held by sharers of the
+	caches, and prints the cost of adding a block and of looking one up at
+	every size along with the mean probe length, so a table whose lookups
+	do more work as it grows shows up apart from the growing cost of
+	missing in the processor caches.
+*/
+int main(int argc, char** argv) {
+	uint32_t caches = 256;
+	uint32_t sharers = 2;
+	uint32_t lookups = 4000000;
+	int option;
+	while ((option = getopt(argc, argv, "c:s:l:")) != -1) {
+		switch (option) {
+			case 'c':
+				if (!parseOption(optarg, &caches) || caches > UINT16_MAX + 1) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 's':
+				if (!parseOption(optarg, &sharers)) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 'l':
+				if (!parseOption(optarg, &lookups)) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc || sharers > caches) {
+		usage(argv[0]);
+		return 1;
+	}
+	printf("%10s %10s %8s %12s %12s %12s\n", "blocks", "slots", "probes", "add ns", "lookup ns", "contains ns");
+	srand(61);
+	for (uint32_t blocks = BENCH_MIN_BLOCKS; blocks <= BENCH_MAX_BLOCKS; blocks <<= 2) {
+		snoopy_t* snooper = createSnooper();
+		double start = now();
+		for (uint32_t i = 0; i < blocks; i++) {
+			uint32_t first = rand() % caches;
+			for (uint32_t j = 0; j < sharers; j++) {
+				addToSnooper(snooper, blockAddress(i), (uint16_t) ((first + j) % caches), BENCH_BLOCK_SIZE);
+			}
+		}
+		double added = now() - start;
+		// Sums the results so the lookups cannot be optimized away
+		volatile int64_t sum = 0;
+		start = now();
+		for (uint32_t i = 0; i < lookups; i++) {
+			sum += returnFirstCacheID(snooper, blockAddress(rand() % blocks), BENCH_BLOCK_SIZE);
+		}
+		double looked = now() - start;
+		start = now();
+		for (uint32_t i = 0; i < lookups; i++) {
+			sum += snooperContains(snooper, blockAddress(rand() % blocks), (uint16_t) (rand() % caches));
+		}
+		double contained = now() - start;
+		printf("%10" PRIu32 " %10" PRIu64 " %8.2f %12.1f %12.1f %12.1f\n", blocks, snooper->numSlots,
+			meanProbes(snooper, blocks), added * 1e9 / ((double) blocks * sharers), looked * 1e9 / lookups, contained * 1e9 / lookups);
+		deleteSnooper(snooper);
+	}
+	return 0;
+}
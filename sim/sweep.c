@@ -0,0 +1,187 @@
+/* Summer 2017 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "../part1/cacheBatch.h"
+#include "../part1/replacement.h"
+#include "trace.h"
+#include "optimal.h"
+#include "sweep.h"
+
+/*
+	Number of requests read from the trace, and replayed, at once.
+*/
+#define SWEEP_BATCH_SIZE 4096
+
+/*
+	Struct used to share a sweep between its threads. next is the index of
+	the next configuration no thread has taken and is guarded by lock.
+*/
+typedef struct sweepJob
+{
+	sweepTrace_t* trace;
+	physicalMemory_t* memory;
+	sweepConfig_t* configs;
+	uint32_t count;
+	uint32_t next;
+	pthread_mutex_t lock;
+} sweepJob_t;
+
+/*
+	Takes in the name of a trace and the size of the read made for bare
+	addresses and decodes the whole trace into memory. Returns NULL if the
+	trace cannot be read or parsed.
+*/
+sweepTrace_t* loadSweepTrace(char* name, uint32_t size) {
+	traceReader_t* reader = openTrace(name, size);
+	if (reader == NULL) {
+		return NULL;
+	}
+	sweepTrace_t* trace = malloc(sizeof(sweepTrace_t));
+	if (trace == NULL) {
+		allocationFailed();
+	}
+	trace->count = 0;
+	trace->capacity = SWEEP_BATCH_SIZE;
+	trace->requests = malloc(sizeof(cacheRequest_t) * trace->capacity);
+	if (trace->requests == NULL) {
+		allocationFailed();
+	}
+	uint32_t read;
+	while ((read = readTrace(reader, trace->requests + trace->count, SWEEP_BATCH_SIZE)) > 0) {
+		trace->count += read;
+		if (trace->capacity - trace->count < SWEEP_BATCH_SIZE) {
+			trace->capacity *= 2;
+			trace->requests = realloc(trace->requests, sizeof(cacheRequest_t) * trace->capacity);
+			if (trace->requests == NULL) {
+				allocationFailed();
+			}
+		}
+	}
+	bool failed = reader->failed;
+	closeTrace(reader);
+	if (failed) {
+		deleteSweepTrace(trace);
+		return NULL;
+	}
+	return trace;
+}
+
+/*
+	Takes in a decoded trace and frees it.
+*/
+void deleteSweepTrace(sweepTrace_t* trace) {
+	if (trace == NULL) {
+		return;
+	}
+	free(trace->requests);
+	free(trace);
+}
+
+/*
+	Takes in a decoded trace, the memory to start from, a configuration,
+	and a buffer of SWEEP_BATCH_SIZE results and replays the trace through
+	a new cache with that configuration, filling in its results.
+*/
+static void runConfig(sweepTrace_t* trace, physicalMemory_t* memory, sweepConfig_t* config,
+	cacheResult_t* results) {
+	cacheOptions_t options = defaultCacheOptions();
+	options.policy = config->policy;
+	options.classifyMisses = true;
+	uint32_t* nextUses = NULL;
+	uint64_t uses = 0;
+	config->valid = false;
+	config->access = 0;
+	config->hit = 0;
+	if (config->policy == OPT_POLICY) {
+		nextUses = findRequestNextUses(trace->requests, trace->count, config->blockDataSize, &uses);
+		if (nextUses == NULL) {
+			return;
+		}
+	}
+	physicalMemory_t* copy = copyPhysicalMemory(memory);
+	cache_t* cache = createCacheWithOptions(config->n, config->blockDataSize, config->totalDataSize, copy, &options);
+	releasePhysicalMemory(copy);
+	if (cache == NULL) {
+		free(nextUses);
+		return;
+	}
+	setNextUses(cache, nextUses, uses);
+	for (uint64_t i = 0; i < trace->count; i += SWEEP_BATCH_SIZE) {
+		uint64_t left = trace->count - i;
+		accessBatch(cache, trace->requests + i, results, left < SWEEP_BATCH_SIZE ? left : SWEEP_BATCH_SIZE);
+	}
+	config->valid = true;
+	config->access = cache->access;
+	config->hit = cache->hit;
+	config->compulsory = cache->misses->compulsory;
+	config->capacity = cache->misses->capacity;
+	config->conflict = cache->misses->conflict;
+	deleteCache(cache);
+	free(nextUses);
+}
+
+/*
+	Takes in a sweep and runs configurations from it until none are left.
+	Used as the body of every thread of the sweep.
+*/
+static void* sweepWorker(void* argument) {
+	sweepJob_t* job = (sweepJob_t*) argument;
+	cacheResult_t* results = malloc(sizeof(cacheResult_t) * SWEEP_BATCH_SIZE);
+	if (results == NULL) {
+		allocationFailed();
+	}
+	while (true) {
+		pthread_mutex_lock(&job->lock);
+		uint32_t index = job->next;
+		job->next += index < job->count;
+		pthread_mutex_unlock(&job->lock);
+		if (index == job->count) {
+			break;
+		}
+		runConfig(job->trace, job->memory, &job->configs[index], results);
+	}
+	free(results);
+	return NULL;
+}
+
+/*
+	Takes in a decoded trace, the memory every cache starts from, an array
+	of configurations, the number of them, and a number of threads and
+	replays the trace through a new cache for every configuration, filling
+	in its results. Threads take the next configuration left whenever they
+	finish one, and each gives its cache a private copy of the memory, so
+	nothing but the trace and the next configuration is shared.
+*/
+void runSweep(sweepTrace_t* trace, physicalMemory_t* memory, sweepConfig_t* configs, uint32_t count,
+	uint32_t threads) {
+	pthread_t workers[SWEEP_MAX_THREADS];
+	sweepJob_t job;
+	job.trace = trace;
+	job.memory = memory;
+	job.configs = configs;
+	job.count = count;
+	job.next = 0;
+	pthread_mutex_init(&job.lock, NULL);
+	if (threads > count) {
+		threads = count;
+	}
+	if (threads > SWEEP_MAX_THREADS) {
+		threads = SWEEP_MAX_THREADS;
+	}
+	uint32_t started = 0;
+	while (started < threads && pthread_create(&workers[started], NULL, sweepWorker, &job) == 0) {
+		started++;
+	}
+	if (started == 0) {
+		sweepWorker(&job);		// Run on this thread if no thread can be started
+	}
+	for (uint32_t i = 0; i < started; i++) {
+		pthread_join(workers[i], NULL);
+	}
+	pthread_mutex_destroy(&job.lock);
+}
@@ -0,0 +1,63 @@
+/* Summer 2017 */
+#ifndef SWEEP_H
+#define SWEEP_H
+
+/*
+	Most threads a sweep runs on at once.
+*/
+#define SWEEP_MAX_THREADS 256
+
+/*
+	Struct used to hold a whole trace decoded into memory so every thread
+	of a sweep replays the same requests without parsing the trace again.
+	requests holds count requests and capacity is how many fit.
+*/
+typedef struct sweepTrace
+{
+	cacheRequest_t* requests;
+	uint64_t count;
+	uint64_t capacity;
+} sweepTrace_t;
+
+/*
+	Struct used to describe one cache of a sweep and hold its results.
+	valid is cleared if the cache cannot be created, and access, hit, and
+	the three kinds of misses are its counts after replaying the trace.
+*/
+typedef struct sweepConfig
+{
+	uint32_t n;
+	uint32_t blockDataSize;
+	uint32_t totalDataSize;
+	enum replacementPolicy policy;
+	bool valid;
+	double access;
+	double hit;
+	double compulsory;
+	double capacity;
+	double conflict;
+} sweepConfig_t;
+
+/*
+	Takes in the name of a trace and the size of the read made for bare
+	addresses and decodes the whole trace into memory. Returns NULL if the
+	trace cannot be read or parsed.
+*/
+sweepTrace_t* loadSweepTrace(char* name, uint32_t size);
+
+/*
+	Takes in a decoded trace and frees it.
+*/
+void deleteSweepTrace(sweepTrace_t* trace);
+
+/*
+	Takes in a decoded trace, the memory every cache starts from, an array
+	of configurations, the number of them, and a number of threads and
+	replays the trace through a new cache for every configuration, filling
+	in its results. Threads take the next configuration left whenever they
+	finish one, and each gives its cache a private copy of the memory, so
+	nothing but the trace and the next configuration is shared.
+*/
+void runSweep(sweepTrace_t* trace, physicalMemory_t* memory, sweepConfig_t* configs, uint32_t count,
+	uint32_t threads);
+#endif
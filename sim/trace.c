@@ -0,0 +1,387 @@
+/* Summer 2017 */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "trace.h"
+
+/*
+	Longest token of a text trace, which is enough for a 64 bit value
+	written in hex with a 0x prefix.
+*/
+#define TOKEN_LENGTH 24
+
+/*
+	Takes in a trace and reads the next part of the file into its buffer.
+	Returns false once the file has no characters left.
+*/
+static bool fillBuffer(traceReader_t* trace) {
+	trace->length = fread(trace->buffer, sizeof(char), TRACE_BUFFER_SIZE, trace->file);
+	trace->position = 0;
+	return trace->length > 0;
+}
+
+/*
+	Takes in a trace and a message and reports that the trace cannot be
+	parsed at the current line, or byte for binary traces, then marks it
+	as failed.
+*/
+static void traceFailed(traceReader_t* trace, char* message) {
+	if (trace->binary) {
+		fprintf(stderr, "%s: byte %" PRIu64 ": %s\n", trace->name, trace->mapPosition, message);
+	} else {
+		fprintf(stderr, "%s:%" PRIu64 ": %s\n", trace->name, trace->line, message);
+	}
+	trace->failed = true;
+}
+
+/*
+	Takes in a trace and a buffer of TOKEN_LENGTH characters and copies the
+	next token of the trace into the buffer, skipping whitespace and
+	comments. Returns the length of the token, which is 0 at the end of
+	the trace or if the token is too long.
+*/
+static uint32_t nextToken(traceReader_t* trace, char* token) {
+	bool comment = false;
+	uint32_t count = 0;
+	while (true) {
+		if (trace->position == trace->length && !fillBuffer(trace)) {
+			return 0;
+		}
+		char c = trace->buffer[trace->position];
+		if (c == '\n') {
+			trace->line++;
+			comment = false;
+		} else if (c == '#') {
+			comment = true;
+		} else if (!comment && c != ' ' && c != '\t' && c != '\r') {
+			break;
+		}
+		trace->position++;
+	}
+	while (trace->position < trace->length || fillBuffer(trace)) {
+		char c = trace->buffer[trace->position];
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '#') {
+			break;
+		}
+		if (count == TOKEN_LENGTH - 1) {
+			traceFailed(trace, "token is too long");
+			return 0;
+		}
+		token[count++] = c;
+		trace->position++;
+	}
+	token[count] = '\0';
+	return count;
+}
+
+/*
+	Takes in a token and a pointer to a value and parses the token as a hex
+	number, with or without a 0x prefix. Returns false if it is not one.
+*/
+static bool parseHex(char* token, uint64_t* value) {
+	if (token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) {
+		token += 2;
+	}
+	if (*token == '\0' || strlen(token) > 16) {
+		return false;
+	}
+	*value = 0;
+	for (; *token != '\0'; token++) {
+		char c = *token;
+		uint64_t digit;
+		if (c >= '0' && c <= '9') {
+			digit = c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			digit = c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			digit = c - 'A' + 10;
+		} else {
+			return false;
+		}
+		*value = (*value << 4) | digit;
+	}
+	return true;
+}
+
+/*
+	Takes in a token and a pointer to a value and parses the token as a
+	decimal number that fits in 32 bits. Returns false if it is not one.
+*/
+static bool parseDecimal(char* token, uint32_t* value) {
+	uint64_t result = 0;
+	if (*token == '\0') {
+		return false;
+	}
+	for (; *token != '\0'; token++) {
+		if (*token < '0' || *token > '9') {
+			return false;
+		}
+		result = result * 10 + (*token - '0');
+		if (result > UINT32_MAX) {
+			return false;
+		}
+	}
+	*value = (uint32_t) result;
+	return true;
+}
+
+/*
+	Takes in a binary trace and a pointer to a value and decodes the next
+	varint of the trace into the value. Returns false if the trace ends in
+	the middle of the varint or it is too long.
+*/
+static bool readVarint(traceReader_t* trace, uint64_t* value) {
+	uint64_t result = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (trace->mapPosition == trace->mapLength) {
+			return false;
+		}
+		uint8_t byte = trace->map[trace->mapPosition++];
+		result |= (uint64_t) (byte & 127) << shift;
+		if ((byte & 128) == 0) {
+			*value = result;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	Takes in a binary trace, an array of requests, and the number of
+	entries in the array and decodes the next records of the trace into
+	the array. Returns the number of requests filled in.
+*/
+static uint32_t readBinary(traceReader_t* trace, cacheRequest_t* requests, uint32_t count) {
+	uint32_t filled = 0;
+	while (filled < count && trace->mapPosition < trace->mapLength) {
+		cacheRequest_t* request = &requests[filled];
+		uint8_t header = trace->map[trace->mapPosition++];
+		uint64_t value;
+		request->op = (header & 1) ? WRITE_ACCESS : READ_ACCESS;
+		request->size = 1 << ((header >> 1) & 3);
+		request->data = 0;
+		if (header & 8) {
+			if (!readVarint(trace, &value) || value > UINT32_MAX) {
+				traceFailed(trace, "record has a bad size");
+				break;
+			}
+			request->size = (uint32_t) value;
+		}
+		if (!readVarint(trace, &value) || value > UINT32_MAX) {
+			traceFailed(trace, "record has a bad address");
+			break;
+		}
+		// The difference is zigzag encoded so small steps down are short too
+		trace->previous += (uint32_t) (value >> 1) ^ -(uint32_t) (value & 1);
+		request->address = trace->previous;
+		if (request->op == WRITE_ACCESS && !readVarint(trace, &request->data)) {
+			traceFailed(trace, "record has bad data");
+			break;
+		}
+		filled++;
+	}
+	return filled;
+}
+
+/*
+	Takes in a buffer and a value and encodes the value into the buffer as
+	a varint. Returns the number of bytes used, at most 10.
+*/
+static uint32_t writeVarint(uint8_t* buffer, uint64_t value) {
+	uint32_t length = 0;
+	while (value >= 128) {
+		buffer[length++] = (uint8_t) (value | 128);
+		value >>= 7;
+	}
+	buffer[length++] = (uint8_t) value;
+	return length;
+}
+
+/*
+	Takes in the name of a trace file and the size in bytes of the access
+	made for every bare address and opens the trace for reading. A text
+	trace is a sequence of whitespace separated records and # starts a
+	comment running to the end of the line. A record is either a bare hex
+	address, as in the *AddressTest.txt files, which is read with the given
+	size, or R addr size or W addr size data with a hex address and data
+	and a decimal size. Addresses below MIN_ADDRESS are taken as offsets
+	from it. Returns NULL if the file cannot be opened.
+*/
+traceReader_t* openTrace(char* name, uint32_t size) {
+	FILE* file = fopen(name, "r");
+	if (file == NULL) {
+		return NULL;
+	}
+	traceReader_t* trace = malloc(sizeof(traceReader_t));
+	if (trace == NULL) {
+		allocationFailed();
+	}
+	trace->name = malloc(strlen(name) + 1);
+	trace->buffer = malloc(TRACE_BUFFER_SIZE);
+	if (trace->name == NULL || trace->buffer == NULL) {
+		allocationFailed();
+	}
+	strcpy(trace->name, name);
+	trace->file = file;
+	trace->position = 0;
+	trace->length = 0;
+	trace->line = 1;
+	trace->size = size;
+	trace->failed = false;
+	trace->binary = false;
+	trace->map = NULL;
+	trace->mapLength = 0;
+	trace->mapPosition = 0;
+	trace->previous = 0;
+
+	char header[sizeof(TRACE_MAGIC)];
+	size_t headerLength = fread(header, sizeof(char), sizeof(header), file);
+	if (headerLength == sizeof(header) && memcmp(header, TRACE_MAGIC, sizeof(header) - 1) == 0
+		&& header[sizeof(header) - 1] == TRACE_VERSION) {
+		struct stat info;
+		if (fstat(fileno(file), &info) == -1) {
+			closeTrace(trace);
+			return NULL;
+		}
+		trace->binary = true;
+		trace->mapLength = info.st_size;
+		trace->mapPosition = sizeof(header);
+		trace->map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+		if (trace->map == MAP_FAILED) {
+			trace->map = NULL;
+			closeTrace(trace);
+			return NULL;
+		}
+		madvise(trace->map, info.st_size, MADV_SEQUENTIAL);
+	} else {
+		// Text traces are parsed from the start, so give back what the check read
+		memcpy(trace->buffer, header, headerLength);
+		trace->length = headerLength;
+	}
+	return trace;
+}
+
+/*
+	Takes in a trace, an array of requests, and the number of entries in
+	the array and fills the array with the next accesses of the trace.
+	Returns the number of requests filled in, which is 0 once the trace
+	has ended. If the trace cannot be parsed failed is set and only the
+	requests before the error are returned.
+*/
+uint32_t readTrace(traceReader_t* trace, cacheRequest_t* requests, uint32_t count) {
+	char token[TOKEN_LENGTH];
+	uint32_t filled = 0;
+	if (trace->binary) {
+		return trace->failed ? 0 : readBinary(trace, requests, count);
+	}
+	while (filled < count && !trace->failed && nextToken(trace, token) > 0) {
+		cacheRequest_t* request = &requests[filled];
+		uint64_t address;
+		request->data = 0;
+		if (token[1] == '\0' && strchr("RrWw", token[0]) != NULL) {
+			request->op = (token[0] == 'W' || token[0] == 'w') ? WRITE_ACCESS : READ_ACCESS;
+			if (nextToken(trace, token) == 0 || !parseHex(token, &address)) {
+				traceFailed(trace, "expected a hex address");
+				break;
+			}
+			if (nextToken(trace, token) == 0 || !parseDecimal(token, &request->size)) {
+				traceFailed(trace, "expected a decimal size");
+				break;
+			}
+			if (request->op == WRITE_ACCESS && (nextToken(trace, token) == 0 || !parseHex(token, &request->data))) {
+				traceFailed(trace, "expected hex data");
+				break;
+			}
+		} else if (parseHex(token, &address)) {
+			request->op = READ_ACCESS;
+			request->size = trace->size;
+		} else {
+			traceFailed(trace, "expected R, W, or a hex address");
+			break;
+		}
+		if (address < MIN_ADDRESS) {
+			address += MIN_ADDRESS;
+		}
+		if (address > UINT32_MAX) {
+			traceFailed(trace, "address does not fit in 32 bits");
+			break;
+		}
+		request->address = (uint32_t) address;
+		filled++;
+	}
+	return filled;
+}
+
+/*
+	Takes in a trace and closes it, freeing everything it uses.
+*/
+void closeTrace(traceReader_t* trace) {
+	if (trace == NULL) {
+		return;
+	}
+	if (trace->map != NULL) {
+		munmap(trace->map, trace->mapLength);
+	}
+	fclose(trace->file);
+	free(trace->buffer);
+	free(trace->name);
+	free(trace);
+}
+
+/*
+	Takes in an open trace and the name of a file and writes every
+	remaining access of the trace to the file in the binary format.
+	Returns the number of accesses written or -1 if the file cannot be
+	written or the trace cannot be parsed.
+*/
+int64_t writeBinaryTrace(traceReader_t* trace, char* name) {
+	FILE* file = fopen(name, "wb");
+	if (file == NULL) {
+		return -1;
+	}
+	cacheRequest_t* requests = malloc(sizeof(cacheRequest_t) * TRACE_BUFFER_SIZE / 32);
+	uint8_t* buffer = malloc(TRACE_BUFFER_SIZE);
+	if (requests == NULL || buffer == NULL) {
+		allocationFailed();
+	}
+	uint8_t header[sizeof(TRACE_MAGIC)] = TRACE_MAGIC;
+	header[sizeof(header) - 1] = TRACE_VERSION;
+	bool failed = fwrite(header, sizeof(uint8_t), sizeof(header), file) != sizeof(header);
+	int64_t written = 0;
+	uint32_t previous = 0;
+	uint32_t count;
+	// A record takes at most 1 + 5 + 5 + 10 bytes, so TRACE_BUFFER_SIZE / 32 of them always fit
+	while (!failed && (count = readTrace(trace, requests, TRACE_BUFFER_SIZE / 32)) > 0) {
+		uint32_t length = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			cacheRequest_t* request = &requests[i];
+			uint32_t size = request->size;
+			bool power = size == 1 || size == 2 || size == 4 || size == 8;
+			int32_t difference = (int32_t) (request->address - previous);
+			uint32_t zigzag = ((uint32_t) difference << 1) ^ (uint32_t) (difference >> 31);
+			buffer[length++] = (request->op == WRITE_ACCESS) | (power ? log_2(size) << 1 : 8);
+			if (!power) {
+				length += writeVarint(buffer + length, size);
+			}
+			length += writeVarint(buffer + length, zigzag);
+			if (request->op == WRITE_ACCESS) {
+				length += writeVarint(buffer + length, request->data);
+			}
+			previous = request->address;
+		}
+		failed = fwrite(buffer, sizeof(uint8_t), length, file) != length;
+		written += count;
+	}
+	free(requests);
+	free(buffer);
+	failed |= fclose(file) != 0;
+	return failed || trace->failed ? -1 : written;
+}
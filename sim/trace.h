@@ -0,0 +1,85 @@
+/* Summer 2017 */
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+	Size of the buffer a text trace is read through. Traces of any length
+	are streamed through it, so memory use does not grow with the trace.
+*/
+#define TRACE_BUFFER_SIZE (1 << 16)
+
+/*
+	First bytes of a binary trace, followed by a version byte. After them
+	every record starts with a byte holding the op in bit 0 and the log
+	base 2 of the size in bits 1 and 2, or bit 3 set if the size is not 1,
+	2, 4, or 8 and follows as a varint. Next is the zigzag encoded
+	difference from the previous address as a varint and, for writes, the
+	data as a varint. Varints hold 7 bits per byte, low bits first, with
+	the top bit set on every byte but the last.
+*/
+#define TRACE_MAGIC "CTRC"
+#define TRACE_VERSION 1
+
+/*
+	Struct used to stream the accesses of a trace file. Text traces are
+	read through buffer, where position is the next character to parse and
+	length the number of characters held. line counts lines for error
+	messages, size is the access size used for bare addresses, and failed
+	is set when the trace holds something that cannot be parsed. Binary
+	traces are mapped instead and decoded in place from map, where
+	mapPosition is the next byte to decode and previous the address of the
+	last record.
+*/
+typedef struct traceReader
+{
+	FILE* file;
+	char* name;
+	char* buffer;
+	uint32_t position;
+	uint32_t length;
+	uint64_t line;
+	uint32_t size;
+	bool failed;
+	bool binary;
+	uint8_t* map;
+	uint64_t mapLength;
+	uint64_t mapPosition;
+	uint32_t previous;
+} traceReader_t;
+
+/*
+	Takes in the name of a trace file and the size in bytes of the access
+	made for every bare address and opens the trace for reading. A text
+	trace is a sequence of whitespace separated records and # starts a
+	comment running to the end of the line. A record is either a bare hex
+	address, as in the *AddressTest.txt files, which is read with the given
+	size, or R addr size or W addr size data with a hex address and data
+	and a decimal size. Addresses below MIN_ADDRESS are taken as offsets
+	from it. Files starting with TRACE_MAGIC are read as binary traces,
+	which are mapped rather than read so they are never copied into the
+	process. Returns NULL if the file cannot be opened.
+*/
+traceReader_t* openTrace(char* name, uint32_t size);
+
+/*
+	Takes in a trace, an array of requests, and the number of entries in
+	the array and fills the array with the next accesses of the trace.
+	Returns the number of requests filled in, which is 0 once the trace
+	has ended. If the trace cannot be parsed failed is set and only the
+	requests before the error are returned.
+*/
+uint32_t readTrace(traceReader_t* trace, cacheRequest_t* requests, uint32_t count);
+
+/*
+	Takes in a trace and closes it, freeing everything it uses.
+*/
+void closeTrace(traceReader_t* trace);
+
+/*
+	Takes in an open trace and the name of a file and writes every
+	remaining access of the trace to the file in the binary format.
+	Returns the number of accesses written or -1 if the file cannot be
+	written or the trace cannot be parsed.
+*/
+int64_t writeBinaryTrace(traceReader_t* trace, char* name);
+#endif
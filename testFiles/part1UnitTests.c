@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <CUnit/Basic.h>
 #include "../part1/utils.h"
 #include "../part1/getFromCache.h"
@@ -9,6 +10,9 @@
 #include "../part1/mem.h"
 #include "../part1/cacheRead.h"
 #include "../part1/cacheWrite.h"
+#include "../part1/cacheBatch.h"
+#include "../part1/replacement.h"
+#include "../part2/hitRate.h"
 
 void test_Utils() {
 	uint32_t n;
@@ -766,6 +770,137 @@ void test_Mem() {
 	deleteCache(cache);
 }
 
+void test_MemImage() {
+	uint32_t n;
+	uint32_t blockDataSize;
+	uint32_t totalDataSize;
+	char* memFile;
+	char* binFile;
+	char* exportFile;
+	cache_t* textCache;
+	cache_t* binCache;
+	cache_t* cache;
+	uint8_t* textData;
+	uint8_t* binData;
+	uint8_t blockContents[8];
+	physicalMemory_t* privateMemory;
+	memFile = "testFiles/physicalMemory1.txt";
+	binFile = "testFiles/physicalMemory1.bin";
+	exportFile = "testFiles/physicalMemory1Export.txt";
+
+	//Test that both formats hold the same memory
+	CU_ASSERT_EQUAL(importPhysicalMemory(memFile, binFile), 0);
+	n = 1;
+	blockDataSize = 8;
+	totalDataSize = 64;
+	textCache = createCache(n, blockDataSize, totalDataSize, memFile);
+	binCache = createCache(n, blockDataSize, totalDataSize, binFile);
+	CU_ASSERT_PTR_NOT_NULL(textCache);
+	CU_ASSERT_PTR_NOT_NULL(binCache);
+	for (uint32_t address = MIN_ADDRESS; address < MAX_ADDRESS; address += 0x10008) {
+		textData = readFromMem(textCache, address);
+		binData = readFromMem(binCache, address);
+		for (int i = 0; i < 8; i++) {
+			CU_ASSERT_EQUAL(textData[i], binData[i]);
+		}
+		free(textData);
+		free(binData);
+	}
+
+	//Test that caches on the same file share one memory
+	cache = createCache(2, blockDataSize, totalDataSize, memFile);
+	CU_ASSERT_PTR_NOT_NULL(cache);
+	CU_ASSERT_EQUAL(cache->memory, textCache->memory);
+	CU_ASSERT_NOT_EQUAL(cache->memory, binCache->memory);
+	for (int i = 0; i < 8; i++) {
+		blockContents[i] = 0xa0 + i;
+	}
+	setData(textCache, blockContents, 0, 8, 0);
+	writeToMem(textCache, 0, 0x61c12340);
+	textData = readFromMem(cache, 0x61c12340);
+	for (int i = 0; i < 8; i++) {
+		CU_ASSERT_EQUAL(textData[i], blockContents[i]);
+	}
+	free(textData);
+	deleteCache(cache);
+	deleteCache(textCache);
+
+	//Test that the write back reached the file
+	textCache = createCache(n, blockDataSize, totalDataSize, memFile);
+	textData = readFromMem(textCache, 0x61c12340);
+	for (int i = 0; i < 8; i++) {
+		CU_ASSERT_EQUAL(textData[i], blockContents[i]);
+	}
+	free(textData);
+	deleteCache(textCache);
+
+	//Test that another path to the same file shares the memory, so neither write is lost
+	textCache = createCache(n, blockDataSize, totalDataSize, memFile);
+	cache = createCache(n, blockDataSize, totalDataSize, "./testFiles/../testFiles/physicalMemory1.txt");
+	CU_ASSERT_PTR_NOT_NULL(cache);
+	CU_ASSERT_EQUAL(cache->memory, textCache->memory);
+	setData(textCache, blockContents, 0, 8, 0);
+	writeToMem(textCache, 0, 0x61c12348);
+	setData(cache, blockContents, 0, 8, 0);
+	writeToMem(cache, 0, 0x61c12350);
+	deleteCache(cache);
+	deleteCache(textCache);
+	textCache = createCache(n, blockDataSize, totalDataSize, memFile);
+	for (uint32_t address = 0x61c12340; address <= 0x61c12350; address += 8) {
+		textData = readFromMem(textCache, address);
+		for (int i = 0; i < 8; i++) {
+			CU_ASSERT_EQUAL(textData[i], blockContents[i]);
+		}
+		free(textData);
+	}
+	deleteCache(textCache);
+
+	//Test exporting a binary image
+	setData(binCache, blockContents, 1, 8, 0);
+	writeToMem(binCache, 1, 0x61cfff00);
+	deleteCache(binCache);
+	CU_ASSERT_EQUAL(exportPhysicalMemory(binFile, exportFile), 0);
+	textCache = createCache(n, blockDataSize, totalDataSize, exportFile);
+	CU_ASSERT_PTR_NOT_NULL(textCache);
+	textData = readFromMem(textCache, 0x61cfff00);
+	for (int i = 0; i < 8; i++) {
+		CU_ASSERT_EQUAL(textData[i], blockContents[i]);
+	}
+	free(textData);
+	deleteCache(textCache);
+
+	//Test that a private memory is a copy that is never written back
+	privateMemory = openPrivatePhysicalMemory(exportFile);
+	CU_ASSERT_PTR_NOT_NULL(privateMemory);
+	cache = createCacheFromMemory(n, blockDataSize, totalDataSize, privateMemory);
+	textCache = createCache(n, blockDataSize, totalDataSize, exportFile);
+	CU_ASSERT_NOT_EQUAL(cache->memory, textCache->memory);
+	CU_ASSERT_EQUAL(readByte(cache, 0x61cfff03).data, blockContents[3]);
+	CU_ASSERT_EQUAL(writeDoubleWord(cache, 0x61cfff00, 0), 0);
+	CU_ASSERT_EQUAL(writeDoubleWord(cache, 0x61c00000, 0), 0);
+	CU_ASSERT_EQUAL(readByte(textCache, 0x61cfff03).data, blockContents[3]);
+	deleteCache(cache);
+	releasePhysicalMemory(privateMemory);
+	deleteCache(textCache);
+	textCache = createCache(n, blockDataSize, totalDataSize, exportFile);
+	CU_ASSERT_EQUAL(readByte(textCache, 0x61cfff03).data, blockContents[3]);
+	deleteCache(textCache);
+	privateMemory = openPrivatePhysicalMemory(NULL);
+	CU_ASSERT_EQUAL(privateMemory->image[0x12345], 0);
+	releasePhysicalMemory(privateMemory);
+
+	//Test that a copy starts from the contents of a memory but is its own
+	privateMemory = openPrivatePhysicalMemory(exportFile);
+	physicalMemory_t* copy = copyPhysicalMemory(privateMemory);
+	CU_ASSERT_NOT_EQUAL(copy->image, privateMemory->image);
+	CU_ASSERT_EQUAL(copy->image[0xfff03], blockContents[3]);
+	copy->image[0xfff03]++;
+	CU_ASSERT_EQUAL(privateMemory->image[0xfff03], blockContents[3]);
+	releasePhysicalMemory(copy);
+	releasePhysicalMemory(privateMemory);
+	CU_ASSERT_PTR_NULL(openPrivatePhysicalMemory("testFiles/missing.txt"));
+}
+
 void test_Read() {
 	uint32_t n;
 	uint32_t blockDataSize;
@@ -1088,6 +1223,50 @@ void test_ReadErrors() {
 
 }
 
+void test_ReadInto() {
+	char* memFile;
+	cache_t* cache;
+	evictionInfo_t info;
+	evictionInfo_t* allocated;
+	uint8_t buffer[16];
+	uint8_t* data;
+	memFile = "testFiles/physicalMemory1.txt";
+
+	cache = createCache(2, 16, 128, memFile);
+	CU_ASSERT_PTR_NOT_NULL(cache);
+
+	//A miss fills the block and a second read of it is a hit
+	readFromCacheInto(cache, 0x61c00010, 8, buffer);
+	CU_ASSERT_EQUAL(cache->access, 1);
+	CU_ASSERT_EQUAL(cache->hit, 0);
+	data = readFromCache(cache, 0x61c00010, 8);
+	CU_ASSERT_EQUAL(cache->hit, 1);
+	CU_ASSERT_EQUAL(memcmp(buffer, data, 8), 0);
+	free(data);
+
+	//The caller owned variants match the allocating ones
+	findEvictionInto(cache, 0x61c00018, &info);
+	allocated = findEviction(cache, 0x61c00018);
+	CU_ASSERT_EQUAL(info.match, 1);
+	CU_ASSERT_EQUAL(info.match, allocated->match);
+	CU_ASSERT_EQUAL(info.blockNumber, allocated->blockNumber);
+	CU_ASSERT_EQUAL(info.LRU, allocated->LRU);
+	free(allocated);
+
+	getDataInto(cache, 0, info.blockNumber, 16, buffer);
+	data = fetchBlock(cache, info.blockNumber);
+	CU_ASSERT_EQUAL(memcmp(buffer, data, 16), 0);
+	free(data);
+	readFromMemInto(cache, 0x61c00010, buffer);
+	data = readFromMem(cache, 0x61c00010);
+	CU_ASSERT_EQUAL(memcmp(buffer, data, 16), 0);
+	fetchBlockInto(cache, info.blockNumber, buffer);
+	CU_ASSERT_EQUAL(memcmp(buffer, data, 16), 0);
+	free(data);
+
+	deleteCache(cache);
+}
+
 void test_Write() {
 	uint32_t n;
 	uint32_t blockDataSize;
@@ -1568,6 +1747,565 @@ void test_writeErrors() {
 
 }
 
+/*
+	Runs the same pseudo random sequence of reads and writes on two caches
+	and checks that every read returns the same data and that both caches
+	count the same accesses and hits.
+*/
+void compareCaches(cache_t* first, cache_t* second, int accesses, uint32_t seed) {
+	uint32_t address;
+	uint32_t random = seed;
+	for (int i = 0; i < accesses; i++) {
+		random = random * 1103515245 + 12345;
+		address = MIN_ADDRESS + ((random >> 8) & 0x3ff8);
+		switch ((random >> 4) & 7) {
+			case 0:
+				CU_ASSERT_EQUAL(writeByte(first, address + 3, (uint8_t) i), writeByte(second, address + 3, (uint8_t) i));
+				break;
+			case 1:
+				CU_ASSERT_EQUAL(writeWord(first, address, random), writeWord(second, address, random));
+				break;
+			case 2:
+				CU_ASSERT_EQUAL(writeDoubleWord(first, address, ((uint64_t) random << 32) | i), writeDoubleWord(second, address, ((uint64_t) random << 32) | i));
+				break;
+			case 3:
+				CU_ASSERT_EQUAL(readByte(first, address + 5).data, readByte(second, address + 5).data);
+				break;
+			case 4:
+				CU_ASSERT_EQUAL(readHalfWord(first, address + 2).data, readHalfWord(second, address + 2).data);
+				break;
+			case 5:
+				CU_ASSERT_EQUAL(readWord(first, address + 4).data, readWord(second, address + 4).data);
+				break;
+			default:
+				CU_ASSERT_EQUAL(readDoubleWord(first, address).data, readDoubleWord(second, address).data);
+				break;
+		}
+	}
+	CU_ASSERT_EQUAL(first->access, second->access);
+	CU_ASSERT_EQUAL(first->hit, second->hit);
+	for (uint32_t i = 0; i < first->totalDataSize / first->blockDataSize; i++) {
+		CU_ASSERT_EQUAL(getValid(first, i), getValid(second, i));
+		CU_ASSERT_EQUAL(getDirty(first, i), getDirty(second, i));
+		CU_ASSERT_EQUAL(getLRU(first, i), getLRU(second, i));
+		if (getValid(first, i)) {
+			CU_ASSERT_EQUAL(extractTag(first, i), extractTag(second, i));
+		}
+	}
+}
+
+void test_RangeAccess() {
+	uint32_t configs[3][3] = {{1, 16, 128}, {2, 8, 64}, {4, 32, 256}};
+	char* memFile;
+	cache_t* range;
+	cache_t* scalar;
+	uint8_t buffer[300];
+	uint8_t expected[300];
+	uint32_t address;
+	memFile = "testFiles/physicalMemory2.txt";
+
+	for (int i = 0; i < 3; i++) {
+		range = createCache(configs[i][0], configs[i][1], configs[i][2], memFile);
+		scalar = createCache(configs[i][0], configs[i][1], configs[i][2], memFile);
+		for (int j = 0; j < 300; j++) {
+			buffer[j] = (uint8_t) (j * 7 + i);
+		}
+
+		//A misaligned write counts the same as the widest aligned writes
+		address = 0x61c00103;
+		CU_ASSERT_EQUAL(cacheWriteRange(range, address, 250, buffer), 0);
+		CU_ASSERT_EQUAL(writeByte(scalar, address, buffer[0]), 0);
+		CU_ASSERT_EQUAL(writeWord(scalar, address + 1, ((uint32_t) buffer[1] << 24) | (buffer[2] << 16) | (buffer[3] << 8) | buffer[4]), 0);
+		for (int j = 5; j < 245; j += 8) {
+			uint64_t value = 0;
+			for (int k = 0; k < 8; k++) {
+				value = (value << 8) | buffer[j + k];
+			}
+			CU_ASSERT_EQUAL(writeDoubleWord(scalar, address + j, value), 0);
+		}
+		CU_ASSERT_EQUAL(writeWord(scalar, address + 245, ((uint32_t) buffer[245] << 24) | (buffer[246] << 16) | (buffer[247] << 8) | buffer[248]), 0);
+		CU_ASSERT_EQUAL(writeByte(scalar, address + 249, buffer[249]), 0);
+		CU_ASSERT_EQUAL(countScalarAccesses(range, address, 250), 34);
+		CU_ASSERT_EQUAL(range->access, scalar->access);
+		CU_ASSERT_EQUAL(range->hit, scalar->hit);
+
+		//Reading back returns the data and both caches hold the same bytes
+		CU_ASSERT_EQUAL(cacheReadRange(range, address - 5, 260, expected), 0);
+		for (int j = 0; j < 250; j++) {
+			CU_ASSERT_EQUAL(expected[j + 5], buffer[j]);
+		}
+		for (int j = 0; j < 260; j++) {
+			CU_ASSERT_EQUAL(readByte(scalar, address - 5 + j).data, expected[j]);
+		}
+
+		//The read counts one access per aligned chunk with the rest of each block hitting
+		range->access = 0;
+		range->hit = 0;
+		CU_ASSERT_EQUAL(cacheReadRange(range, 0x61c08000, 64, expected), 0);
+		CU_ASSERT_EQUAL(range->access, 8);
+		CU_ASSERT_EQUAL(range->hit, 8 - 64 / configs[i][1]);
+
+		CU_ASSERT_EQUAL(cacheReadRange(range, 0x61cffff0, 32, expected), -1);
+		CU_ASSERT_EQUAL(cacheWriteRange(range, 0x61bffff0, 32, buffer), -1);
+		deleteCache(range);
+		deleteCache(scalar);
+	}
+}
+
+/*
+	Performs a batch request on a cache with the typed read or write of its
+	size, storing the data read in data. Returns whether it succeeded.
+*/
+bool performRequest(cache_t* cache, cacheRequest_t* request, uint64_t* data) {
+	if (request->op == WRITE_ACCESS) {
+		switch (request->size) {
+			case 1:
+				return writeByte(cache, request->address, (uint8_t) request->data) == 0;
+			case 2:
+				return writeHalfWord(cache, request->address, (uint16_t) request->data) == 0;
+			case 4:
+				return writeWord(cache, request->address, (uint32_t) request->data) == 0;
+			case 8:
+				return writeDoubleWord(cache, request->address, request->data) == 0;
+		}
+		return false;
+	}
+	switch (request->size) {
+		case 1: {
+			byteInfo_t read = readByte(cache, request->address);
+			*data = read.data;
+			return read.success;
+		}
+		case 2: {
+			halfWordInfo_t read = readHalfWord(cache, request->address);
+			*data = read.data;
+			return read.success;
+		}
+		case 4: {
+			wordInfo_t read = readWord(cache, request->address);
+			*data = read.data;
+			return read.success;
+		}
+		case 8: {
+			doubleWordInfo_t read = readDoubleWord(cache, request->address);
+			*data = read.data;
+			return read.success;
+		}
+	}
+	return false;
+}
+
+void test_Batch() {
+	uint32_t configs[3][3] = {{1, 16, 128}, {4, 4, 64}, {2, 64, 512}};
+	uint32_t sizes[4] = {1, 2, 4, 8};
+	char* memFile;
+	char* binFile;
+	cache_t* batch;
+	cache_t* scalar;
+	cacheRequest_t requests[400];
+	cacheResult_t results[400];
+	uint32_t random;
+	uint32_t successes;
+	uint64_t data;
+	double hits;
+	double accesses;
+	memFile = "testFiles/physicalMemory3.txt";
+	binFile = "testFiles/physicalMemory3.bin";
+
+	for (int i = 0; i < 3; i++) {
+		//The caches need separate memories so write backs of one are not seen by the other
+		CU_ASSERT_EQUAL(importPhysicalMemory(memFile, binFile), 0);
+		batch = createCache(configs[i][0], configs[i][1], configs[i][2], memFile);
+		scalar = createCache(configs[i][0], configs[i][1], configs[i][2], binFile);
+		random = i + 7;
+		for (int j = 0; j < 400; j++) {
+			random = random * 1103515245 + 12345;
+			requests[j].op = (random >> 3) & 1 ? WRITE_ACCESS : READ_ACCESS;
+			requests[j].size = sizes[(random >> 5) & 3];
+			requests[j].address = MIN_ADDRESS + ((random >> 12) & 0x1f8) + (((random >> 7) & 3) << 1);
+			requests[j].data = ((uint64_t) random << 32) | j;
+		}
+		//Invalid requests are skipped
+		requests[10].address = MAX_ADDRESS - 1;
+		requests[10].size = 4;
+		requests[11].size = 3;
+		requests[12].address = MIN_ADDRESS + 1;
+		requests[12].size = 2;
+
+		successes = accessBatch(batch, requests, results, 400);
+		CU_ASSERT_EQUAL(results[10].success, false);
+		CU_ASSERT_EQUAL(results[11].success, false);
+		CU_ASSERT_EQUAL(results[12].success, false);
+		for (int j = 0; j < 400; j++) {
+			data = 0;
+			hits = scalar->hit;
+			accesses = scalar->access;
+			CU_ASSERT_EQUAL(results[j].success, performRequest(scalar, &requests[j], &data));
+			successes -= results[j].success;
+			if (results[j].success) {
+				CU_ASSERT_EQUAL(results[j].hit, scalar->hit - hits == scalar->access - accesses);
+				if (requests[j].op == READ_ACCESS) {
+					CU_ASSERT_EQUAL(results[j].data, data);
+				}
+			}
+		}
+		CU_ASSERT_EQUAL(successes, 0);
+		CU_ASSERT_EQUAL(batch->access, scalar->access);
+		CU_ASSERT_EQUAL(batch->hit, scalar->hit);
+		for (uint32_t j = 0; j < batch->totalDataSize / batch->blockDataSize; j++) {
+			CU_ASSERT_EQUAL(getDirty(batch, j), getDirty(scalar, j));
+			CU_ASSERT_EQUAL(getLRU(batch, j), getLRU(scalar, j));
+			CU_ASSERT_EQUAL(extractTag(batch, j), extractTag(scalar, j));
+		}
+		deleteCache(batch);
+		deleteCache(scalar);
+	}
+}
+
+void test_PLRU() {
+	uint32_t configs[4][3] = {{4, 16, 256}, {8, 8, 512}, {16, 32, 512}, {2, 4, 64}};
+	char* memFile;
+	physicalMemory_t* memory;
+	cacheOptions_t options;
+	cache_t* lru;
+	cache_t* packed;
+	cache_t* fast;
+	memFile = "testFiles/physicalMemory2.txt";
+	options = defaultCacheOptions();
+	options.policy = PLRU_POLICY;
+	memory = openPrivatePhysicalMemory(memFile);
+
+	//The tree replaces the per block ages with n - 1 bits per set
+	for (int i = 0; i < 4; i++) {
+		lru = createCacheFromMemory(configs[i][0], configs[i][1], configs[i][2], memory);
+		packed = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], memory, &options);
+		CU_ASSERT_EQUAL(numLRUBits(packed), 0);
+		CU_ASSERT_EQUAL(totalBlockBits(packed), totalBlockBits(lru) - numLRUBits(lru));
+		CU_ASSERT_EQUAL(cacheSizeBits(packed), cacheSizeBits(lru) - (uint64_t) numLRUBits(lru) * (configs[i][2] / configs[i][1])
+			+ (configs[i][0] - 1) * getNumSets(lru));
+		CU_ASSERT_EQUAL((cacheSizeBits(packed) + numGarbageBits(packed)) & 7, 0);
+		CU_ASSERT_EQUAL(packed->geometry.allocBytes, cacheSizeBytes(packed));
+		deleteCache(lru);
+		deleteCache(packed);
+	}
+
+	//Fill A B C D, touch A, then E replaces C where LRU would replace B
+	packed = createCacheWithOptions(4, 8, 32, memory, &options);
+	for (uint32_t i = 0; i < 4; i++) {
+		readByte(packed, 0x61c00000 + (i << 3));
+	}
+	readByte(packed, 0x61c00000);
+	readByte(packed, 0x61c00020);
+	CU_ASSERT_EQUAL(packed->hit, 1);
+	readByte(packed, 0x61c00008);
+	CU_ASSERT_EQUAL(packed->hit, 2);
+	readByte(packed, 0x61c00010);
+	CU_ASSERT_EQUAL(packed->hit, 2);
+	deleteCache(packed);
+	releasePhysicalMemory(memory);
+
+	//Both layouts make the same choices
+	for (int i = 0; i < 4; i++) {
+		options.layout = PACKED_LAYOUT;
+		packed = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], openPrivatePhysicalMemory(memFile), &options);
+		options.layout = FAST_LAYOUT;
+		fast = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], openPrivatePhysicalMemory(memFile), &options);
+		releasePhysicalMemory(packed->memory);
+		releasePhysicalMemory(fast->memory);
+		compareCaches(packed, fast, 3000, i + 1);
+		deleteCache(packed);
+		deleteCache(fast);
+	}
+}
+
+void test_RRIP() {
+	uint32_t configs[4][3] = {{4, 16, 256}, {8, 8, 512}, {16, 32, 512}, {2, 4, 64}};
+	enum replacementPolicy policies[3] = {SRRIP_POLICY, BRRIP_POLICY, DRRIP_POLICY};
+	char* memFile;
+	physicalMemory_t* memory;
+	cacheOptions_t options;
+	cache_t* lru;
+	cache_t* rrip;
+	cache_t* packed;
+	cache_t* fast;
+	memFile = "testFiles/physicalMemory2.txt";
+	options = defaultCacheOptions();
+	memory = openPrivatePhysicalMemory(memFile);
+
+	//A scan of new blocks does not flush blocks that were reused
+	options.policy = SRRIP_POLICY;
+	lru = createCacheFromMemory(4, 8, 32, memory);
+	rrip = createCacheWithOptions(4, 8, 32, memory, &options);
+	for (int i = 0; i < 4; i++) {
+		readByte(lru, 0x61c00000 + ((i & 1) << 3));
+		readByte(rrip, 0x61c00000 + ((i & 1) << 3));
+	}
+	for (uint32_t i = 2; i < 8; i++) {
+		readByte(lru, 0x61c00000 + (i << 3));
+		readByte(rrip, 0x61c00000 + (i << 3));
+	}
+	CU_ASSERT_EQUAL(getLRUAddress(rrip, 0x61c00000), 2);
+	readByte(lru, 0x61c00000);
+	readByte(rrip, 0x61c00000);
+	readByte(lru, 0x61c00008);
+	readByte(rrip, 0x61c00008);
+	CU_ASSERT_EQUAL(lru->hit, 2);
+	CU_ASSERT_EQUAL(rrip->hit, 4);
+	CU_ASSERT_EQUAL(getLRUAddress(rrip, 0x61c00000), 0);
+	deleteCache(lru);
+	deleteCache(rrip);
+
+	//BRRIP inserts with a distant prediction except once a period
+	options.policy = BRRIP_POLICY;
+	rrip = createCacheWithOptions(4, 8, 256, memory, &options);
+	for (uint32_t i = 0; i < RRIP_BIMODAL_PERIOD; i++) {
+		readByte(rrip, 0x61c00000 + (i << 3));
+		CU_ASSERT_EQUAL(getLRUAddress(rrip, 0x61c00000 + (i << 3)), i == RRIP_BIMODAL_PERIOD - 1 ? RRIP_MAX - 1 : RRIP_MAX);
+	}
+	deleteCache(rrip);
+
+	//Misses in the SRRIP leader move the other sets to BRRIP
+	options.policy = DRRIP_POLICY;
+	rrip = createCacheWithOptions(2, 8, 64, memory, &options);
+	readByte(rrip, 0x61c00000);
+	CU_ASSERT_EQUAL(getLRUAddress(rrip, 0x61c00000), RRIP_MAX - 1);
+	CU_ASSERT_EQUAL(rrip->policySelector, (1 << (RRIP_SELECTOR_BITS - 1)) + 1);
+	readByte(rrip, 0x61c00008);
+	CU_ASSERT_EQUAL(getLRUAddress(rrip, 0x61c00008), RRIP_MAX);
+	readByte(rrip, 0x61c00010);
+	CU_ASSERT_EQUAL(rrip->policySelector, 1 << (RRIP_SELECTOR_BITS - 1));
+	readByte(rrip, 0x61c00018);
+	CU_ASSERT_EQUAL(getLRUAddress(rrip, 0x61c00018), RRIP_MAX - 1);
+	CU_ASSERT_EQUAL(cacheSizeBits(rrip), (uint64_t) 8 * (3 + RRIP_BITS + 27 + 64) + log_2(RRIP_BIMODAL_PERIOD) + RRIP_SELECTOR_BITS);
+	CU_ASSERT_EQUAL(numGarbageBits(rrip), 8 - (log_2(RRIP_BIMODAL_PERIOD) + RRIP_SELECTOR_BITS) % 8);
+	CU_ASSERT_EQUAL(rrip->geometry.allocBytes, cacheSizeBytes(rrip));
+	deleteCache(rrip);
+	releasePhysicalMemory(memory);
+
+	//Both layouts make the same choices
+	for (int p = 0; p < 3; p++) {
+		options.policy = policies[p];
+		for (int i = 0; i < 4; i++) {
+			options.layout = PACKED_LAYOUT;
+			packed = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], openPrivatePhysicalMemory(memFile), &options);
+			options.layout = FAST_LAYOUT;
+			fast = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], openPrivatePhysicalMemory(memFile), &options);
+			releasePhysicalMemory(packed->memory);
+			releasePhysicalMemory(fast->memory);
+			compareCaches(packed, fast, 3000, i + 1);
+			deleteCache(packed);
+			deleteCache(fast);
+		}
+	}
+}
+
+void test_PolicyEngines() {
+	uint32_t configs[4][3] = {{4, 16, 256}, {8, 8, 512}, {16, 32, 512}, {2, 4, 64}};
+	enum replacementPolicy policies[5] = {FIFO_POLICY, RANDOM_POLICY, LFU_POLICY, CLOCK_POLICY, NRU_POLICY};
+	uint8_t blockBits[5] = {2, 0, LFU_BITS, 1, 1};
+	uint32_t cacheBits[5] = {0, RANDOM_BITS, 0, 0, 0};
+	uint8_t data[16];
+	char* memFile;
+	physicalMemory_t* memory;
+	cacheOptions_t options;
+	cache_t* lru;
+	cache_t* cache;
+	cache_t* packed;
+	cache_t* fast;
+	memFile = "testFiles/physicalMemory2.txt";
+	options = defaultCacheOptions();
+	memory = openPrivatePhysicalMemory(memFile);
+
+	//Every policy pays for its own state
+	lru = createCacheFromMemory(4, 16, 256, memory);
+	for (int p = 0; p < 5; p++) {
+		options.policy = policies[p];
+		cache = createCacheWithOptions(4, 16, 256, memory, &options);
+		CU_ASSERT(cache->engine == policyEngine(policies[p]));
+		CU_ASSERT_EQUAL(numLRUBits(cache), blockBits[p]);
+		CU_ASSERT_EQUAL(totalBlockBits(cache), totalBlockBits(lru) - 2 + blockBits[p]);
+		CU_ASSERT_EQUAL(cacheSizeBits(cache), (uint64_t) 16 * totalBlockBits(cache) + cacheBits[p]
+			+ (policies[p] == CLOCK_POLICY ? 4 * 2 : 0));
+		deleteCache(cache);
+	}
+	deleteCache(lru);
+
+	//FIFO ignores hits, so A goes first even after it is used again
+	options.policy = FIFO_POLICY;
+	cache = createCacheWithOptions(4, 8, 32, memory, &options);
+	for (uint32_t i = 0; i < 4; i++) {
+		readByte(cache, 0x61c00000 + (i << 3));
+	}
+	readByte(cache, 0x61c00000);
+	readByte(cache, 0x61c00020);
+	readByte(cache, 0x61c00008);
+	CU_ASSERT_EQUAL(cache->hit, 2);
+	readByte(cache, 0x61c00000);
+	CU_ASSERT_EQUAL(cache->hit, 2);
+	deleteCache(cache);
+
+	//LFU counts the accesses of a range that reuse its block
+	options.policy = LFU_POLICY;
+	cache = createCacheWithOptions(4, 16, 64, memory, &options);
+	for (uint32_t i = 0; i < 4; i++) {
+		readByte(cache, 0x61c00000 + (i << 4));
+	}
+	for (uint32_t i = 0; i < 6; i++) {
+		readByte(cache, 0x61c00000 + ((i % 3) << 4));
+	}
+	CU_ASSERT_EQUAL(cacheReadRange(cache, 0x61c00030, 16, data), 0);
+	CU_ASSERT_EQUAL(getLRUAddress(cache, 0x61c00030), LFU_MAX - 3);
+	readByte(cache, 0x61c00040);
+	readByte(cache, 0x61c00030);
+	CU_ASSERT_EQUAL(cache->hit, 9);
+	deleteCache(cache);
+
+	//CLOCK gives C a second chance and sweeps past it to D
+	options.policy = CLOCK_POLICY;
+	cache = createCacheWithOptions(4, 8, 32, memory, &options);
+	for (uint32_t i = 0; i < 5; i++) {
+		readByte(cache, 0x61c00000 + (i << 3));
+	}
+	readByte(cache, 0x61c00010);
+	readByte(cache, 0x61c00028);
+	readByte(cache, 0x61c00030);
+	CU_ASSERT_EQUAL(cache->hit, 1);
+	readByte(cache, 0x61c00010);
+	CU_ASSERT_EQUAL(cache->hit, 2);
+	readByte(cache, 0x61c00018);
+	CU_ASSERT_EQUAL(cache->hit, 2);
+	deleteCache(cache);
+
+	//NRU evicts the first block not used since the set was last all used
+	options.policy = NRU_POLICY;
+	cache = createCacheWithOptions(4, 8, 32, memory, &options);
+	for (uint32_t i = 0; i < 4; i++) {
+		readByte(cache, 0x61c00000 + (i << 3));
+	}
+	readByte(cache, 0x61c00000);
+	readByte(cache, 0x61c00020);
+	CU_ASSERT_EQUAL(getLRUAddress(cache, 0x61c00010), 1);
+	readByte(cache, 0x61c00000);
+	readByte(cache, 0x61c00018);
+	CU_ASSERT_EQUAL(cache->hit, 3);
+	readByte(cache, 0x61c00008);
+	CU_ASSERT_EQUAL(cache->hit, 3);
+	deleteCache(cache);
+
+	//RANDOM repeats itself from the same seed
+	options.policy = RANDOM_POLICY;
+	options.seed = 61;
+	cache = createCacheWithOptions(4, 8, 64, memory, &options);
+	lru = createCacheWithOptions(4, 8, 64, memory, &options);
+	for (uint32_t i = 0; i < 200; i++) {
+		readByte(cache, 0x61c00000 + ((i * 7) % 13 << 3));
+	}
+	double hits = cache->hit;
+	clearCache(cache);
+	for (uint32_t i = 0; i < 200; i++) {
+		readByte(cache, 0x61c00000 + ((i * 7) % 13 << 3));
+		readByte(lru, 0x61c00000 + ((i * 7) % 13 << 3));
+	}
+	CU_ASSERT_EQUAL(cache->hit, hits);
+	CU_ASSERT_EQUAL(lru->hit, hits);
+	deleteCache(cache);
+	deleteCache(lru);
+	releasePhysicalMemory(memory);
+
+	//Both layouts make the same choices
+	for (int p = 0; p < 5; p++) {
+		options.policy = policies[p];
+		for (int i = 0; i < 4; i++) {
+			options.layout = PACKED_LAYOUT;
+			packed = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], openPrivatePhysicalMemory(memFile), &options);
+			options.layout = FAST_LAYOUT;
+			fast = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], openPrivatePhysicalMemory(memFile), &options);
+			releasePhysicalMemory(packed->memory);
+			releasePhysicalMemory(fast->memory);
+			compareCaches(packed, fast, 3000, i + 1);
+			deleteCache(packed);
+			deleteCache(fast);
+		}
+	}
+}
+
+void test_OPT() {
+	uint32_t addresses[6] = {0x61c00000, 0x61c00001, 0x61c00008, 0x61c00010, 0x61c00000, 0x61c00008};
+	uint32_t nextUses[6] = {1, 4, 5, OPT_NEVER, OPT_NEVER, OPT_NEVER};
+	cacheRequest_t requests[6];
+	cacheResult_t results[6];
+	physicalMemory_t* memory;
+	cacheOptions_t options;
+	cache_t* lru;
+	cache_t* opt;
+	options = defaultCacheOptions();
+	options.policy = OPT_POLICY;
+	memory = openPrivatePhysicalMemory("testFiles/physicalMemory2.txt");
+	lru = createCacheFromMemory(2, 8, 16, memory);
+	opt = createCacheWithOptions(2, 8, 16, memory, &options);
+	CU_ASSERT_EQUAL(cacheSizeBits(opt), cacheSizeBits(lru) - 2);
+	setNextUses(opt, nextUses, 6);
+	for (int i = 0; i < 6; i++) {
+		requests[i].op = READ_ACCESS;
+		requests[i].address = addresses[i];
+		requests[i].size = 1;
+		requests[i].data = 0;
+	}
+
+	//C replaces B, which is used again later than A, where LRU replaces A
+	CU_ASSERT_EQUAL(accessBatch(lru, requests, results, 6), 6);
+	CU_ASSERT_EQUAL(lru->hit, 1);
+	for (int j = 0; j < 2; j++) {
+		CU_ASSERT_EQUAL(accessBatch(opt, requests, results, 6), 6);
+		CU_ASSERT_EQUAL(opt->hit, 2);
+		CU_ASSERT_EQUAL(results[1].hit, true);
+		CU_ASSERT_EQUAL(results[4].hit, true);
+		CU_ASSERT_EQUAL(results[5].hit, false);
+		CU_ASSERT_EQUAL(opt->usePosition, 6);
+		clearCache(opt);
+	}
+	deleteCache(lru);
+	deleteCache(opt);
+	releasePhysicalMemory(memory);
+}
+
+void test_FastLayout() {
+	uint32_t configs[5][3] = {{1, 8, 128}, {4, 16, 256}, {16, 32, 512}, {2, 2, 64}, {8, 64, 4096}};
+	char* memFile;
+	char* binFile;
+	physicalMemory_t* packedMemory;
+	physicalMemory_t* fastMemory;
+	cacheOptions_t options;
+	cache_t* packed;
+	cache_t* fast;
+	memFile = "testFiles/physicalMemory4.txt";
+	binFile = "testFiles/physicalMemory4.bin";
+
+	options = defaultCacheOptions();
+	options.layout = FAST_LAYOUT;
+	for (int i = 0; i < 5; i++) {
+		CU_ASSERT_EQUAL(importPhysicalMemory(memFile, binFile), 0);
+		packedMemory = openPhysicalMemory(memFile);
+		fastMemory = openPhysicalMemory(binFile);
+		packed = createCacheFromMemory(configs[i][0], configs[i][1], configs[i][2], packedMemory);
+		fast = createCacheWithOptions(configs[i][0], configs[i][1], configs[i][2], fastMemory, &options);
+		CU_ASSERT_PTR_NOT_NULL(fast);
+
+		//The fast layout reports the modeled size
+		CU_ASSERT_EQUAL(cacheSizeBits(fast), cacheSizeBits(packed));
+		CU_ASSERT_EQUAL(cacheSizeBytes(fast), cacheSizeBytes(packed));
+		CU_ASSERT_EQUAL(totalBlockBits(fast), totalBlockBits(packed));
+		CU_ASSERT_EQUAL(numGarbageBits(fast), numGarbageBits(packed));
+		CU_ASSERT_EQUAL(getDataLocation(fast, 1, 0) & 63, 0);
+
+		compareCaches(packed, fast, 3000, i + 1);
+		deleteCache(packed);
+		deleteCache(fast);
+		releasePhysicalMemory(packedMemory);
+		releasePhysicalMemory(fastMemory);
+	}
+}
+
 void test_CreateDMCache() {
 	uint32_t n;
 	uint32_t blockDataSize;
@@ -1748,6 +2486,72 @@ void test_Create4WaysCache() {
 }
 
 
+void test_SetSampling() {
+	cacheRequest_t requests[4000];
+	cacheRequest_t filtered[4000];
+	cacheResult_t results[4000];
+	cacheResult_t expected[4000];
+	physicalMemory_t* memory;
+	physicalMemory_t* sampledMemory;
+	cacheOptions_t options;
+	cache_t* full;
+	cache_t* partial;
+	cache_t* sampled;
+	uint32_t count = 0;
+	memory = openPrivatePhysicalMemory("testFiles/physicalMemory1.txt");
+	sampledMemory = openPrivatePhysicalMemory("testFiles/physicalMemory1.txt");
+	options = defaultCacheOptions();
+
+	//Ratios must be powers of 2 no larger than the number of sets
+	options.sampleRatio = 3;
+	CU_ASSERT_PTR_NULL(createCacheWithOptions(2, 16, 1024, memory, &options));
+	options.sampleRatio = 64;
+	CU_ASSERT_PTR_NULL(createCacheWithOptions(2, 16, 1024, memory, &options));
+	options.sampleRatio = 4;
+	options.policy = OPT_POLICY;
+	CU_ASSERT_PTR_NULL(createCacheWithOptions(2, 16, 1024, memory, &options));
+	options.policy = LRU_POLICY;
+
+	full = createCacheFromMemory(2, 16, 1024, memory);
+	partial = createCacheFromMemory(2, 16, 1024, memory);
+	sampled = createCacheWithOptions(2, 16, 1024, sampledMemory, &options);
+	CU_ASSERT_EQUAL(sampled->sampledSets, 8);
+	srand(61);
+	for (int i = 0; i < 4000; i++) {
+		requests[i].size = 1 << (rand() % 4);
+		requests[i].address = 0x61c00000 + (rand() % 8192) * 8;
+		requests[i].op = rand() % 3 == 0 ? WRITE_ACCESS : READ_ACCESS;
+		requests[i].data = ((uint64_t) rand() << 32 | rand()) & (UINT64_MAX >> (64 - 8 * requests[i].size));
+		if (sampleSlot(sampled, getIndex(sampled, requests[i].address)) < sampled->sampledSets) {
+			filtered[count++] = requests[i];
+		}
+	}
+	accessBatch(full, requests, expected, 4000);
+	accessBatch(sampled, requests, results, 4000);
+
+	//Every access still reads and writes the right data
+	for (int i = 0; i < 4000; i++) {
+		CU_ASSERT_EQUAL(results[i].data, expected[i].data);
+	}
+
+	//The sampled sets behave exactly as they do in the whole cache
+	accessBatch(partial, filtered, expected, count);
+	CU_ASSERT_EQUAL(sampled->access, partial->access);
+	CU_ASSERT_EQUAL(sampled->hit, partial->hit);
+	CU_ASSERT_EQUAL(sampled->access + sampled->skipped, full->access);
+	CU_ASSERT(hitRateMargin(sampled) > 0);
+	CU_ASSERT_EQUAL(hitRateMargin(full), 0);
+	clearCache(sampled);
+	CU_ASSERT_EQUAL(sampled->skipped, 0);
+	CU_ASSERT_EQUAL(sampled->setAccesses[0], 0);
+
+	deleteCache(full);
+	deleteCache(partial);
+	deleteCache(sampled);
+	releasePhysicalMemory(memory);
+	releasePhysicalMemory(sampledMemory);
+}
+
 int main(int argc, char** argv) {
 	CU_pSuite pSuite1 = NULL;
 	CU_pSuite pSuite2 = NULL;
@@ -1767,6 +2571,9 @@ int main(int argc, char** argv) {
     		if (!CU_add_test(pSuite1, "test_Mem", test_Mem)) {
         		goto exit;
     		}
+    		if (!CU_add_test(pSuite1, "test_MemImage", test_MemImage)) {
+        		goto exit;
+    		}
     	case 1:
     		if (!CU_add_test(pSuite1, "test_Utils", test_Utils)) {
         		goto exit;
@@ -1800,6 +2607,9 @@ int main(int argc, char** argv) {
     		if (!CU_add_test(pSuite1, "test_ReadErrors", test_ReadErrors)) {
     			goto exit;
     		}
+    		if (!CU_add_test(pSuite1, "test_ReadInto", test_ReadInto)) {
+    			goto exit;
+    		}
     		if (argc - 1) {
     			break;
     		}
@@ -1823,6 +2633,30 @@ int main(int argc, char** argv) {
     		if (!CU_add_test(pSuite2, "test_Create4WaysCache", test_Create4WaysCache)) {
         		goto exit;
     		}
+    		if (!CU_add_test(pSuite2, "test_FastLayout", test_FastLayout)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_RangeAccess", test_RangeAccess)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_Batch", test_Batch)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_PLRU", test_PLRU)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_RRIP", test_RRIP)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_PolicyEngines", test_PolicyEngines)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_OPT", test_OPT)) {
+        		goto exit;
+    		}
+    		if (!CU_add_test(pSuite2, "test_SetSampling", test_SetSampling)) {
+        		goto exit;
+    		}
     }
 
     CU_basic_set_mode(CU_BRM_VERBOSE);
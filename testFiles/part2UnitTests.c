@@ -7,6 +7,7 @@
 #include "../part1/cacheWrite.h"
 #include "../part1/mem.h"
 #include "../part2/hitRate.h"
+#include "../part2/stackDistance.h"
 #include "../part2/problem1.h"
 #include "../part2/problem2.h"
 #include "../part2/problem3.h"
@@ -445,6 +446,134 @@ void test_Problem3HitRate() {
 }
 
 
+/*
+	Tests that the stack distances of one pass give the hit rate of every
+	LRU cache, with memory blocks large enough that the timelines of the
+	sets fill up and get compacted.
+*/
+void test_StackDistance() {
+	uint32_t blockSizes[2] = {8, 4096};
+	uint32_t maxSizes[2] = {256, 65536};
+	uint32_t spans[2] = {1024, 1 << 20};
+	uint32_t addresses[3000];
+	physicalMemory_t* memory;
+	stackDistance_t* tracker;
+	cache_t* cache;
+	memory = openPrivatePhysicalMemory("testFiles/physicalMemory1.txt");
+	CU_ASSERT_PTR_NULL(createStackDistance(8, 4));
+	CU_ASSERT_PTR_NULL(createStackDistance(12, 96));
+
+	srand(61);
+	for (int b = 0; b < 2; b++) {
+		tracker = createStackDistance(blockSizes[b], maxSizes[b]);
+		CU_ASSERT_PTR_NOT_NULL(tracker);
+		for (int i = 0; i < 3000; i++) {
+			// Reuse recent addresses often so every distance shows up
+			addresses[i] = i > 0 && rand() % 2 ? addresses[rand() % i] : 0x61c00000 + rand() % spans[b];
+			recordAccess(tracker, addresses[i]);
+		}
+		for (uint32_t total = blockSizes[b]; total <= maxSizes[b]; total <<= 1) {
+			for (uint32_t n = 1; n * blockSizes[b] <= total; n <<= 1) {
+				cache = createCacheFromMemory(n, blockSizes[b], total, memory);
+				for (int i = 0; i < 3000; i++) {
+					readByte(cache, addresses[i]);
+				}
+				CU_ASSERT_EQUAL(stackHitRate(tracker, n, total), findHitRate(cache));
+				deleteCache(cache);
+			}
+		}
+		CU_ASSERT_EQUAL(stackHitRate(tracker, 1, maxSizes[b] * 2), -1);
+		deleteStackDistance(tracker);
+	}
+	releasePhysicalMemory(memory);
+}
+
+void test_SampledStackDistance() {
+	stackDistance_t* exact;
+	stackDistance_t* sampled;
+	uint32_t address;
+	CU_ASSERT_PTR_NULL(createSampledStackDistance(64, 4096, 0));
+	CU_ASSERT_PTR_NULL(createSampledStackDistance(64, 4096, 1.5));
+
+	// Sampling every block gives the exact curve
+	exact = createStackDistance(64, 4096);
+	sampled = createSampledStackDistance(64, 4096, 1);
+	srand(61);
+	for (int i = 0; i < 5000; i++) {
+		address = 0x61c00000 + rand() % 16384;
+		recordAccess(exact, address);
+		recordAccess(sampled, address);
+	}
+	CU_ASSERT_EQUAL(sampled->sampled, 5000);
+	for (uint32_t n = 1; n <= 64; n <<= 1) {
+		CU_ASSERT_EQUAL(stackHitRate(sampled, n, 4096), stackHitRate(exact, n, 4096));
+	}
+	deleteStackDistance(exact);
+	deleteStackDistance(sampled);
+
+	// A skewed trace over every block of memory is estimated closely by a
+	// tenth of its blocks once caches have many more ways than 10
+	exact = createStackDistance(64, 262144);
+	sampled = createSampledStackDistance(64, 262144, 0.1);
+	for (int i = 0; i < 400000; i++) {
+		address = 0x61c00000 + (rand() % (rand() % 16384 + 1)) * 64;
+		recordAccess(exact, address);
+		recordAccess(sampled, address);
+	}
+	CU_ASSERT(sampled->sampled > 20000 && sampled->sampled < 80000);
+	for (uint32_t total = 16384; total <= 262144; total <<= 1) {
+		double error = stackHitRate(sampled, total / 64, total) - stackHitRate(exact, total / 64, total);
+		CU_ASSERT(error < 0.02 && error > -0.02);
+	}
+	deleteStackDistance(exact);
+	deleteStackDistance(sampled);
+}
+
+void test_MissClassification() {
+	uint32_t addresses[7] = {0x61c00000, 0x61c00010, 0x61c00000, 0x61c00008, 0x61c00018, 0x61c00010, 0x61c00018};
+	physicalMemory_t* memory;
+	cacheOptions_t options;
+	cache_t* cache;
+	cache_t* full;
+	memory = openPrivatePhysicalMemory("testFiles/physicalMemory1.txt");
+	options = defaultCacheOptions();
+	options.classifyMisses = true;
+
+	//A miss to a block a fully associative cache would still hold is a conflict
+	cache = createCacheWithOptions(1, 8, 16, memory, &options);
+	for (int i = 0; i < 7; i++) {
+		readByte(cache, addresses[i]);
+	}
+	CU_ASSERT_EQUAL(cache->misses->compulsory, 4);
+	CU_ASSERT_EQUAL(cache->misses->conflict, 1);
+	CU_ASSERT_EQUAL(cache->misses->capacity, 1);
+	CU_ASSERT_EQUAL(cache->hit, 1);
+	clearCache(cache);
+	CU_ASSERT_EQUAL(cache->misses->compulsory, 0);
+	readByte(cache, addresses[0]);
+	CU_ASSERT_EQUAL(cache->misses->compulsory, 1);
+	deleteCache(cache);
+
+	//Every miss is classified once, and a fully associative cache has no conflicts
+	cache = createCacheWithOptions(2, 16, 512, memory, &options);
+	full = createCacheWithOptions(32, 16, 512, memory, &options);
+	srand(61);
+	for (int i = 0; i < 5000; i++) {
+		uint32_t address = 0x61c00000 + rand() % 2048;
+		writeByte(cache, address, 1);
+		writeByte(full, address, 1);
+	}
+	CU_ASSERT_EQUAL(cache->misses->compulsory + cache->misses->capacity + cache->misses->conflict,
+		cache->access - cache->hit);
+	CU_ASSERT_EQUAL(cache->misses->compulsory, 128);
+	CU_ASSERT(cache->misses->conflict > 0);
+	CU_ASSERT_EQUAL(full->misses->conflict, 0);
+	CU_ASSERT_EQUAL(full->misses->compulsory + full->misses->capacity, full->access - full->hit);
+	deleteCache(cache);
+	deleteCache(full);
+	releasePhysicalMemory(memory);
+}
+
 int main() {
 	CU_pSuite pSuite1 = NULL;
 	CU_pSuite pSuite2 = NULL;
@@ -469,6 +598,15 @@ int main() {
     if (!CU_add_test(pSuite1, "test_HitRate2", test_HitRate2)) {
         goto exit;
     }
+    if (!CU_add_test(pSuite1, "test_StackDistance", test_StackDistance)) {
+        goto exit;
+    }
+    if (!CU_add_test(pSuite1, "test_SampledStackDistance", test_SampledStackDistance)) {
+        goto exit;
+    }
+    if (!CU_add_test(pSuite1, "test_MissClassification", test_MissClassification)) {
+        goto exit;
+    }
     pSuite2 = CU_add_suite("Testing Problem 1", NULL, NULL);
     if (!CU_add_test(pSuite2, "test_Problem1HitRate", test_Problem1HitRate)) {
         goto exit;
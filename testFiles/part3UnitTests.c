@@ -209,6 +209,24 @@ void test_States() {
 
 
 	deleteCache(cache);
+
+	//An invalid way left with the same tag does not age the set a second time
+	cache = createCache(4, 8, 32, memFile);
+	for (uint32_t i = 0; i < 3; i++) {
+		setTag(cache, getTag(cache, 0x61c00000 + 8 * i), i);
+		setState(cache, i, SHARED);
+		setLRU(cache, i, i + 1);
+	}
+	setTag(cache, getTag(cache, 0x61c00008), 3);
+	setState(cache, 3, INVALID);
+	setLRU(cache, 3, 0);
+	updateState(cache, 0x61c00008, MODIFIED);
+	CU_ASSERT_EQUAL(determineState(cache, 0x61c00008), INVALID);
+	CU_ASSERT_EQUAL(getLRU(cache, 0), 1);
+	CU_ASSERT_EQUAL(getLRU(cache, 1), 3);
+	CU_ASSERT_EQUAL(getLRU(cache, 2), 2);
+	CU_ASSERT_EQUAL(getLRU(cache, 3), 0);
+	deleteCache(cache);
 }
 
 void test_CoherenceReads() {
@@ -936,6 +954,287 @@ void test_TwoCaches() {
 	deleteCacheSystem(sys);
 }
 
+void test_SharedMemory() {
+	uint32_t n;
+	uint32_t blockDataSize;
+	uint32_t totalDataSize;
+	physicalMemory_t* memory;
+	cacheSystem_t* sys;
+	cacheNode_t** lst;
+	cacheNode_t* otherNodes[2];
+	cache_t* otherCache;
+	uint8_t* mem;
+
+	n = 2;
+	blockDataSize = 8;
+	totalDataSize = 64;
+	memory = openPhysicalMemory("testFiles/physicalMemory3.txt");
+	CU_ASSERT_PTR_NOT_NULL(memory);
+	lst = malloc(sizeof(cacheNode_t*) * 2);
+	lst[0] = createCacheNode(createCacheFromMemory(n, blockDataSize, totalDataSize, memory), 1);
+	lst[1] = createCacheNode(createCacheFromMemory(n, blockDataSize, totalDataSize, memory), 2);
+	CU_ASSERT_EQUAL(lst[0]->cache->memory, memory);
+	CU_ASSERT_EQUAL(lst[1]->cache->memory, memory);
+
+	//Caches on another memory cannot join the system
+	otherCache = createCache(n, blockDataSize, totalDataSize, "testFiles/physicalMemory4.txt");
+	otherNodes[0] = lst[0];
+	otherNodes[1] = createCacheNode(otherCache, 3);
+	CU_ASSERT_EQUAL(createCacheSystem(otherNodes, 2, createSnooper()), NULL);
+	deleteCache(otherCache);
+	free(otherNodes[1]);
+
+	sys = createCacheSystem(lst, 2, createSnooper());
+	CU_ASSERT_PTR_NOT_NULL(sys);
+	CU_ASSERT_EQUAL(sys->memory, memory);
+	releasePhysicalMemory(memory);
+
+	//A block written back by one cache is seen by the other
+	CU_ASSERT_EQUAL(cacheSystemWordWrite(sys, 0x61c00040, 1, 0xdeadbeef), 0);
+	CU_ASSERT_EQUAL(cacheSystemWordWrite(sys, 0x61c00080, 1, 0), 0);
+	CU_ASSERT_EQUAL(cacheSystemWordWrite(sys, 0x61c000c0, 1, 0), 0);
+	CU_ASSERT_EQUAL(determineState(getCacheFromID(sys, 1), 0x61c00040), INVALID);
+	mem = readFromMem(getCacheFromID(sys, 2), 0x61c00040);
+	CU_ASSERT_EQUAL(mem[0], 0xde);
+	CU_ASSERT_EQUAL(mem[3], 0xef);
+	free(mem);
+	CU_ASSERT_EQUAL(cacheSystemWordRead(sys, 0x61c00040, 2).data, 0xdeadbeef);
+	deleteCacheSystem(sys);
+
+	//The system flushed the memory when it was deleted
+	otherCache = createCache(n, blockDataSize, totalDataSize, "testFiles/physicalMemory3.txt");
+	CU_ASSERT_PTR_NOT_NULL(otherCache);
+	mem = readFromMem(otherCache, 0x61c00040);
+	CU_ASSERT_EQUAL(mem[0], 0xde);
+	CU_ASSERT_EQUAL(mem[3], 0xef);
+	free(mem);
+	deleteCache(otherCache);
+}
+
+void test_ManyCaches() {
+	uint32_t size = 300;
+	physicalMemory_t* memory;
+	cacheSystem_t* sys;
+	cacheNode_t** lst;
+	cacheNode_t* otherNodes[2];
+	snoopy_t* snooper;
+
+	memory = openPrivatePhysicalMemory(NULL);
+	lst = malloc(sizeof(cacheNode_t*) * size);
+	for (uint32_t i = 0; i < size; i++) {
+		lst[i] = createCacheNode(createCacheFromMemory(1, 8, 64, memory), i + 1);
+	}
+	//IDs must stay unique
+	otherNodes[0] = lst[0];
+	otherNodes[1] = createCacheNode(lst[1]->cache, 1);
+	snooper = createSnooper();
+	CU_ASSERT_PTR_NULL(createCacheSystem(otherNodes, 2, snooper));
+	deleteSnooper(snooper);
+	free(otherNodes[1]);
+
+	sys = createCacheSystem(lst, size, createSnooper());
+	CU_ASSERT_PTR_NOT_NULL(sys);
+	releasePhysicalMemory(memory);
+	CU_ASSERT_EQUAL(sys->size, size);
+	CU_ASSERT_EQUAL(getCacheFromID(sys, 300), lst[299]->cache);
+	CU_ASSERT_PTR_NULL(getCacheFromID(sys, 301));
+	CU_ASSERT_PTR_NULL(getCacheFromID(sys, 0));
+	CU_ASSERT_EQUAL(sys->indexSize, 301);
+
+	//Every cache shares the block until the last one writes it
+	CU_ASSERT_EQUAL(cacheSystemWordWrite(sys, 0x61c00040, 1, 0xdeadbeef), 0);
+	for (uint32_t i = 2; i <= size; i++) {
+		CU_ASSERT_EQUAL(cacheSystemWordRead(sys, 0x61c00040, i).data, 0xdeadbeef);
+	}
+	CU_ASSERT_EQUAL(determineState(getCacheFromID(sys, 1), 0x61c00040), OWNED);
+	CU_ASSERT_EQUAL(determineState(getCacheFromID(sys, 300), 0x61c00040), SHARED);
+	CU_ASSERT_EQUAL(cacheSystemWordWrite(sys, 0x61c00040, 300, 0xfeedf00d), 0);
+	for (uint32_t i = 1; i < size; i++) {
+		CU_ASSERT_EQUAL(determineState(getCacheFromID(sys, i), 0x61c00040), INVALID);
+	}
+	CU_ASSERT_EQUAL(determineState(getCacheFromID(sys, 300), 0x61c00040), MODIFIED);
+	CU_ASSERT_EQUAL(returnIDIf1(sys->snooper, 0x61c00040, 8), 300);
+	CU_ASSERT_EQUAL(cacheSystemWordRead(sys, 0x61c00040, 7).data, 0xfeedf00d);
+	deleteCacheSystem(sys);
+}
+
+void test_Directory() {
+	cacheSystem_t* systems[2];
+	cacheNode_t** lst;
+	physicalMemory_t* memory;
+
+	for (int mode = 0; mode < 2; mode++) {
+		memory = openPrivatePhysicalMemory(NULL);
+		lst = malloc(sizeof(cacheNode_t*) * 4);
+		for (uint32_t i = 0; i < 4; i++) {
+			lst[i] = createCacheNode(createCacheFromMemory(2, 8, 64, memory), i + 1);
+		}
+		systems[mode] = mode == 0 ? createCacheSystem(lst, 4, createSnooper()) : createDirectorySystem(lst, 4);
+		CU_ASSERT_PTR_NOT_NULL(systems[mode]);
+		releasePhysicalMemory(memory);
+	}
+	CU_ASSERT_EQUAL(systems[0]->mode, SNOOPING);
+	CU_ASSERT_EQUAL(systems[1]->mode, DIRECTORY);
+	CU_ASSERT_PTR_NULL(systems[1]->snooper);
+	CU_ASSERT_PTR_NOT_NULL(systems[1]->homes);
+	//Blocks are homed on the directories in turn
+	CU_ASSERT_EQUAL(homeSnooper(systems[1], 0x61c00040), systems[1]->homes[0]);
+	CU_ASSERT_EQUAL(homeSnooper(systems[1], 0x61c0004f), systems[1]->homes[1]);
+	CU_ASSERT_EQUAL(homeSnooper(systems[0], 0x61c0004f), systems[0]->snooper);
+
+	//A miss to memory, a read from a holder, and an upgrade
+	for (int mode = 0; mode < 2; mode++) {
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c00040, 1).data, 0);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c00040, 2).data, 0);
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c00040, 2, 0xdeadbeef), 0);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.requests, 3);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.forwards, 1);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.invalidations, 1);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.data, 2);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.evictions, 0);
+	}
+	CU_ASSERT_EQUAL(systems[0]->traffic.acks, 0);
+	CU_ASSERT_EQUAL(systems[0]->traffic.messages, 11);
+	CU_ASSERT_EQUAL(systems[1]->traffic.acks, 1);
+	CU_ASSERT_EQUAL(systems[1]->traffic.messages, 8);
+
+	//Clean blocks of one cache are evicted, then a dirty block of another
+	for (int mode = 0; mode < 2; mode++) {
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c00060, 2).data, 0);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c00080, 2).data, 0);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c000a0, 2).data, 0);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.data, 5);
+	}
+	//Snooping drops the clean blocks silently
+	CU_ASSERT_EQUAL(systems[0]->traffic.evictions, 0);
+	CU_ASSERT_EQUAL(systems[0]->traffic.messages, 23);
+	CU_ASSERT_EQUAL(systems[1]->traffic.evictions, 2);
+	CU_ASSERT_EQUAL(systems[1]->traffic.messages, 16);
+	for (int mode = 0; mode < 2; mode++) {
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c00048, 3, 1), 0);
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c00068, 3, 1), 0);
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c00088, 3, 1), 0);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.requests, 9);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.data, 9);		// Three fills and a writeback
+	}
+	//The dirty block only costs its writeback when snooping
+	CU_ASSERT_EQUAL(systems[0]->traffic.evictions, 0);
+	CU_ASSERT_EQUAL(systems[0]->traffic.messages, 36);
+	CU_ASSERT_EQUAL(systems[1]->traffic.evictions, 3);
+	CU_ASSERT_EQUAL(systems[1]->traffic.messages, 24);
+
+	//Both systems keep every cache in the same state
+	srand(61);
+	for (int i = 0; i < 4000; i++) {
+		uint32_t address = 0x61c00000 + (rand() % 64) * 4;
+		uint16_t ID = rand() % 4 + 1;
+		uint32_t values[2] = {rand(), 0};
+		bool write = rand() % 3 == 0;
+		for (int mode = 0; mode < 2; mode++) {
+			if (write) {
+				CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], address, ID, values[0]), 0);
+			} else {
+				values[mode] = cacheSystemWordRead(systems[mode], address, ID).data;
+			}
+		}
+		CU_ASSERT(write || values[0] == values[1]);
+		for (uint16_t j = 1; j <= 4; j++) {
+			CU_ASSERT_EQUAL(determineState(getCacheFromID(systems[0], j), address),
+				determineState(getCacheFromID(systems[1], j), address));
+		}
+	}
+	CU_ASSERT(systems[1]->traffic.evictions > 2);
+	CU_ASSERT_EQUAL(systems[0]->traffic.evictions, 0);
+	CU_ASSERT_EQUAL(systems[0]->traffic.requests, systems[1]->traffic.requests);
+	CU_ASSERT_EQUAL(systems[0]->traffic.data, systems[1]->traffic.data);
+
+	//A stale entry of the writer is dropped instead of fetching the block from itself
+	for (int mode = 0; mode < 2; mode++) {
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c00000, 4, 0xaaaaaaaa), 0);
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c00004, 4, 0xbbbbbbbb), 0);
+		uint64_t invalidations = systems[mode]->traffic.invalidations;
+		addToSnooper(homeSnooper(systems[mode], 0x61c80000), 0x61c80000, 4, 8);
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c80000, 4, 1), 0);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.invalidations, invalidations);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c80000, 4).data, 1);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c80004, 4).data, 0);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c80000, 1).data, 1);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c00000, 1).data, 0xaaaaaaaa);
+		addToSnooper(homeSnooper(systems[mode], 0x61c80040), 0x61c80040, 2, 8);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c80044, 2).data, 0);
+		CU_ASSERT(snooperContains(homeSnooper(systems[mode], 0x61c80040), 0x61c80040, 2));
+
+		//A write miss to a block another cache holds keeps the data written
+		CU_ASSERT_EQUAL(cacheSystemWordWrite(systems[mode], 0x61c80000, 2, 0x22222222), 0);
+		CU_ASSERT_EQUAL(systems[mode]->traffic.invalidations, invalidations + 1);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c80000, 2).data, 0x22222222);
+		CU_ASSERT_EQUAL(cacheSystemWordRead(systems[mode], 0x61c80000, 3).data, 0x22222222);
+	}
+	CU_ASSERT_EQUAL(systems[0]->traffic.acks, 0);
+	CU_ASSERT_EQUAL(systems[1]->traffic.acks, systems[1]->traffic.invalidations);
+	deleteCacheSystem(systems[0]);
+	deleteCacheSystem(systems[1]);
+}
+
+void test_Snooper() {
+	uint16_t IDs[6] = {1, 2, 3, 63, 64, 1000};
+	bool present[512][6] = {{false}};
+	uint32_t counts[512] = {0};
+	uint32_t contents = 0;
+	bool resized = false;
+	snoopy_t* snooper = createSnooper();
+	srand(61);
+	for (int i = 0; i < 20000; i++) {
+		uint32_t block = rand() % (i < 10000 ? 512 : 64);
+		uint8_t j = rand() % (i < 5000 ? 3 : 6);
+		uint32_t address = 0x61c00000 + block * 16;
+		int op = rand() % 20;
+		if (op < 13) {
+			addToSnooper(snooper, address + rand() % 16, IDs[j], 16);
+			contents += counts[block] == 0;
+			counts[block] += !present[block][j];
+			present[block][j] = true;
+		} else if (op < 19) {
+			removeFromSnooper(snooper, address, IDs[j], 16);
+			counts[block] -= present[block][j];
+			contents -= present[block][j] && counts[block] == 0;
+			present[block][j] = false;
+		} else {
+			removeAllFromSnooper(snooper, address + rand() % 16, 16);
+			contents -= counts[block] != 0;
+			counts[block] = 0;
+			for (j = 0; j < 6; j++) {
+				present[block][j] = false;
+			}
+		}
+		resized |= snooper->oldAddresses != NULL;
+		CU_ASSERT_EQUAL(snooper->numContents, contents);
+		if (i % 500 != 0 && i != 19999) {
+			continue;
+		}
+		//Every lookup agrees with the entries added, even in the middle of a resize
+		for (uint32_t b = 0; b < 512; b++) {
+			int only = -1;
+			int next = -1;
+			for (j = 0; j < 6; j++) {
+				CU_ASSERT_EQUAL(snooperContains(snooper, 0x61c00000 + b * 16, IDs[j]), present[b][j]);
+				only = present[b][j] ? IDs[j] : only;
+				if (present[b][j]) {
+					next = next == -1 ? returnFirstCacheID(snooper, 0x61c00000 + b * 16 + 5, 16)
+						: returnNextCacheID(snooper, 0x61c00000 + b * 16, 16, next);
+					CU_ASSERT_EQUAL(next, IDs[j]);
+				}
+			}
+			CU_ASSERT_EQUAL(returnNextCacheID(snooper, 0x61c00000 + b * 16, 16, next), -1);
+			CU_ASSERT_EQUAL(returnIDIf1(snooper, 0x61c00000 + b * 16, 16), (counts[b] == 1 ? only : -1));
+		}
+	}
+	CU_ASSERT(resized);
+	CU_ASSERT_EQUAL(snooper->sharerWords, 16);
+	CU_ASSERT(snooper->numSlots >= 2 * snooper->numContents);
+	deleteSnooper(snooper);
+}
+
 int main(int argc, char** argv) {
 	CU_pSuite pSuite1 = NULL;
 	CU_pSuite pSuite2 = NULL;
@@ -955,10 +1254,22 @@ int main(int argc, char** argv) {
     		if (!CU_add_test(pSuite2, "test_TwoCaches", test_TwoCaches)) {
         		goto exit;
  			}
+    		if (!CU_add_test(pSuite2, "test_SharedMemory", test_SharedMemory)) {
+        		goto exit;
+ 			}
+    		if (!CU_add_test(pSuite2, "test_ManyCaches", test_ManyCaches)) {
+        		goto exit;
+ 			}
+    		if (!CU_add_test(pSuite2, "test_Directory", test_Directory)) {
+        		goto exit;
+ 			}
     	case 1:
     		if (!CU_add_test(pSuite1, "test_States", test_States)) {
         		goto exit;
     		}
+    		if (!CU_add_test(pSuite1, "test_Snooper", test_Snooper)) {
+        		goto exit;
+    		}
     		if (argc - 1) {
     			break;
     		}
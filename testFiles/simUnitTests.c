@@ -0,0 +1,612 @@
+#include <CUnit/Basic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../part1/utils.h"
+#include "../part1/mem.h"
+#include "../part1/cacheBatch.h"
+#include "../part1/replacement.h"
+#include "../sim/trace.h"
+#include "../sim/optimal.h"
+#include "../sim/sweep.h"
+
+#define TEXT_TRACE "testFiles/simTrace.txt"
+#define BINARY_TRACE "testFiles/simTrace.bin"
+
+/*
+	Takes in the name of a file, its contents, and their length and writes
+	the file, replacing it if it exists.
+*/
+static void writeFile(char* name, void* contents, size_t length) {
+	FILE* file = fopen(name, "wb");
+	CU_ASSERT_PTR_NOT_NULL(file);
+	CU_ASSERT_EQUAL(fwrite(contents, sizeof(char), length, file), length);
+	fclose(file);
+}
+
+/*
+	Takes in the name of a trace, the size of bare addresses, an array of
+	requests, and the number of entries in the array and reads the whole
+	trace into it. Sets failed to whether the trace could not be parsed.
+	Returns the number of requests read.
+*/
+static uint32_t readWholeTrace(char* name, uint32_t size, cacheRequest_t* requests, uint32_t count, bool* failed) {
+	traceReader_t* trace = openTrace(name, size);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	if (trace == NULL) {
+		*failed = true;
+		return 0;
+	}
+	uint32_t total = 0;
+	uint32_t read;
+	// Reads a few at a time so records are split across calls too
+	while (total < count && (read = readTrace(trace, requests + total, count - total < 3 ? count - total : 3)) > 0) {
+		total += read;
+	}
+	*failed = trace->failed;
+	closeTrace(trace);
+	return total;
+}
+
+/*
+	Tests that text traces are parsed into the right requests, with bare
+	addresses read at the given size and small addresses taken as offsets.
+*/
+void test_TextTrace() {
+	char* text = "# bare addresses\n"
+		"0x61c00004 61c00008\t0X61C0000C\r\n"
+		"r 0x61c00010 1 # a comment after a record\n"
+		"R 0x61c00012 2 w 0x61c00018 8 0xFFFFFFFFFFFFFFFF\n"
+		"W 0x61c00014 4 12345678\n"
+		"\n"
+		"   # offsets from MIN_ADDRESS\n"
+		"0x0 ff R 0x40 8\n"
+		"W 4 4 0x1\n"
+		"0x61bffffc\n";
+	cacheRequest_t expected[] = {
+		{READ_ACCESS, 0x61c00004, 2, 0},
+		{READ_ACCESS, 0x61c00008, 2, 0},
+		{READ_ACCESS, 0x61c0000c, 2, 0},
+		{READ_ACCESS, 0x61c00010, 1, 0},
+		{READ_ACCESS, 0x61c00012, 2, 0},
+		{WRITE_ACCESS, 0x61c00018, 8, UINT64_MAX},
+		{WRITE_ACCESS, 0x61c00014, 4, 0x12345678},
+		{READ_ACCESS, 0x61c00000, 2, 0},
+		{READ_ACCESS, 0x61c000ff, 2, 0},
+		{READ_ACCESS, 0x61c00040, 8, 0},
+		{WRITE_ACCESS, 0x61c00004, 4, 1},
+		{READ_ACCESS, 0xc37ffffc, 2, 0},
+	};
+	uint32_t count = sizeof(expected) / sizeof(cacheRequest_t);
+	cacheRequest_t requests[16];
+	bool failed;
+	writeFile(TEXT_TRACE, text, strlen(text));
+	CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 2, requests, 16, &failed), count);
+	CU_ASSERT_FALSE(failed);
+	for (uint32_t i = 0; i < count; i++) {
+		CU_ASSERT_EQUAL(requests[i].op, expected[i].op);
+		CU_ASSERT_EQUAL(requests[i].address, expected[i].address);
+		CU_ASSERT_EQUAL(requests[i].size, expected[i].size);
+		CU_ASSERT_EQUAL(requests[i].data, expected[i].data);
+	}
+
+	// Traces of nothing but whitespace and comments have no requests
+	writeFile(TEXT_TRACE, " \n# 0x61c00000\n\t", 16);
+	CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 2, requests, 16, &failed), 0);
+	CU_ASSERT_FALSE(failed);
+	writeFile(TEXT_TRACE, "", 0);
+	CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 2, requests, 16, &failed), 0);
+	CU_ASSERT_FALSE(failed);
+
+	// The given trace files are still read as bare words
+	CU_ASSERT_EQUAL(readWholeTrace("testFiles/10AddressTest.txt", 4, requests, 16, &failed), 10);
+	CU_ASSERT_FALSE(failed);
+	for (uint32_t i = 0; i < 10; i++) {
+		CU_ASSERT_EQUAL(requests[i].op, READ_ACCESS);
+		CU_ASSERT_EQUAL(requests[i].size, 4);
+		CU_ASSERT_TRUE(requests[i].address >= MIN_ADDRESS);
+	}
+	remove(TEXT_TRACE);
+}
+
+/*
+	Tests records and comments that are split between two reads of the
+	trace buffer. The first TRACE_BUFFER_SIZE bytes are read after the 5
+	bytes openTrace checks for a binary header, so the buffer first ends
+	after byte TRACE_BUFFER_SIZE + 5. The record is moved across that point
+	one byte at a time, behind padding of either spaces or a comment.
+*/
+void test_TextTraceBoundary() {
+	char* record = "W 0x61c00010 4 0xabcd1234\nR 20 8\n";
+	uint32_t recordLength = strlen(record);
+	uint32_t boundary = TRACE_BUFFER_SIZE + 5;
+	char* text = malloc(boundary + recordLength);
+	CU_ASSERT_PTR_NOT_NULL(text);
+	cacheRequest_t requests[4];
+	bool failed;
+	for (uint32_t comment = 0; comment < 2; comment++) {
+		for (uint32_t before = 1; before <= recordLength + 1; before++) {
+			uint32_t padding = boundary - before;
+			memset(text, ' ', padding);
+			if (comment) {
+				text[0] = '#';
+				text[padding - 1] = '\n';
+			}
+			memcpy(text + padding, record, recordLength);
+			writeFile(TEXT_TRACE, text, padding + recordLength);
+			CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 4, requests, 4, &failed), 2);
+			CU_ASSERT_FALSE(failed);
+			CU_ASSERT_EQUAL(requests[0].op, WRITE_ACCESS);
+			CU_ASSERT_EQUAL(requests[0].address, 0x61c00010);
+			CU_ASSERT_EQUAL(requests[0].size, 4);
+			CU_ASSERT_EQUAL(requests[0].data, 0xabcd1234);
+			CU_ASSERT_EQUAL(requests[1].op, READ_ACCESS);
+			CU_ASSERT_EQUAL(requests[1].address, 0x61c00020);
+			CU_ASSERT_EQUAL(requests[1].size, 8);
+		}
+	}
+
+	// Many records spanning several reads of the buffer
+	uint32_t lines = 3 * TRACE_BUFFER_SIZE / 16;
+	FILE* file = fopen(TEXT_TRACE, "w");
+	CU_ASSERT_PTR_NOT_NULL(file);
+	for (uint32_t i = 0; i < lines; i++) {
+		fprintf(file, i % 2 ? "R %x 4\n" : "W %x 4 %x\n", (i * 4) % MEMORY_SIZE, i);
+	}
+	fclose(file);
+	traceReader_t* trace = openTrace(TEXT_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	uint32_t total = 0;
+	while (readTrace(trace, requests, 1) == 1) {
+		CU_ASSERT_EQUAL(requests[0].op, total % 2 ? READ_ACCESS : WRITE_ACCESS);
+		CU_ASSERT_EQUAL(requests[0].address, MIN_ADDRESS + (total * 4) % MEMORY_SIZE);
+		CU_ASSERT_EQUAL(requests[0].data, total % 2 ? 0 : total);
+		total++;
+	}
+	CU_ASSERT_EQUAL(total, lines);
+	CU_ASSERT_FALSE(trace->failed);
+	CU_ASSERT_EQUAL(trace->line, lines + 1);
+	closeTrace(trace);
+	free(text);
+	remove(TEXT_TRACE);
+}
+
+/*
+	Tests that malformed text traces set failed and keep only the requests
+	before the error.
+*/
+void test_TextTraceErrors() {
+	char* traces[] = {
+		"0x61c00000 0x61c0zz00",
+		"0x61c00000 Q 0x61c00000 4",
+		"0x61c00000 R",
+		"0x61c00000 R 0x61c00000",
+		"0x61c00000 R 0x61c00000 four",
+		"0x61c00000 R 0x61c00000 -4",
+		"0x61c00000 R 0x61c00000 4294967296",
+		"0x61c00000 R zz 4",
+		"0x61c00000 W 0x61c00000 4",
+		"0x61c00000 W 0x61c00000 4 0xg",
+		"0x61c00000 W 0x61c00000 4 0x10000000000000000",
+		"0x61c00000 0x",
+		"0x61c00000 0x100000000",
+		"0x61c00000 0xffffffffa0000000",
+		"0x61c00000 RW 0x61c00000 4",
+		"0x61c00000 0x00000000000000000000000000000000",
+	};
+	cacheRequest_t requests[4];
+	bool failed;
+	for (uint32_t i = 0; i < sizeof(traces) / sizeof(char*); i++) {
+		writeFile(TEXT_TRACE, traces[i], strlen(traces[i]));
+		CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 4, requests, 4, &failed), 1);
+		CU_ASSERT_TRUE(failed);
+		CU_ASSERT_EQUAL(requests[0].address, 0x61c00000);
+	}
+
+	// The line of the error is reported
+	writeFile(TEXT_TRACE, "0x10\n# zz\n\n zz\n0x20\n", 20);
+	traceReader_t* trace = openTrace(TEXT_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_EQUAL(readTrace(trace, requests, 4), 1);
+	CU_ASSERT_TRUE(trace->failed);
+	CU_ASSERT_EQUAL(trace->line, 4);
+	CU_ASSERT_EQUAL(readTrace(trace, requests, 4), 0);
+	closeTrace(trace);
+
+	CU_ASSERT_PTR_NULL(openTrace("testFiles/missingTrace.txt", 4));
+	remove(TEXT_TRACE);
+}
+
+/*
+	Converts a text trace to the binary format and checks that both decode
+	to the same requests, including steps down in address, sizes that are
+	not a power of 2, and data wider than 32 bits.
+*/
+void test_BinaryRoundTrip() {
+	char* text = "0x61c00100\n"
+		"W 0x61c00108 8 0xfedcba9876543210\n"
+		"# steps back down\n"
+		"R 0x61c00000 2\n"
+		"R 0x61c0fff0 3\n"
+		"W 0x61c00004 4 0x0\n"
+		"W 10 1 ff\n"
+		"R 0x61cffff8 64\n"
+		"0x20\n";
+	cacheRequest_t expected[] = {
+		{READ_ACCESS, 0x61c00100, 4, 0},
+		{WRITE_ACCESS, 0x61c00108, 8, UINT64_C(0xfedcba9876543210)},
+		{READ_ACCESS, 0x61c00000, 2, 0},
+		{READ_ACCESS, 0x61c0fff0, 3, 0},
+		{WRITE_ACCESS, 0x61c00004, 4, 0},
+		{WRITE_ACCESS, 0x61c00010, 1, 0xff},
+		{READ_ACCESS, 0x61cffff8, 64, 0},
+		{READ_ACCESS, 0x61c00020, 4, 0},
+	};
+	uint32_t count = sizeof(expected) / sizeof(cacheRequest_t);
+	cacheRequest_t textRequests[16];
+	cacheRequest_t binaryRequests[16];
+	bool failed;
+	writeFile(TEXT_TRACE, text, strlen(text));
+
+	traceReader_t* trace = openTrace(TEXT_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_FALSE(trace->binary);
+	CU_ASSERT_EQUAL(writeBinaryTrace(trace, BINARY_TRACE), count);
+	closeTrace(trace);
+
+	CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 4, textRequests, 16, &failed), count);
+	CU_ASSERT_FALSE(failed);
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, binaryRequests, 16, &failed), count);
+	CU_ASSERT_FALSE(failed);
+	for (uint32_t i = 0; i < count; i++) {
+		CU_ASSERT_EQUAL(textRequests[i].op, expected[i].op);
+		CU_ASSERT_EQUAL(textRequests[i].address, expected[i].address);
+		CU_ASSERT_EQUAL(textRequests[i].size, expected[i].size);
+		CU_ASSERT_EQUAL(textRequests[i].data, expected[i].data);
+		CU_ASSERT_EQUAL(binaryRequests[i].op, textRequests[i].op);
+		CU_ASSERT_EQUAL(binaryRequests[i].address, textRequests[i].address);
+		CU_ASSERT_EQUAL(binaryRequests[i].size, textRequests[i].size);
+		CU_ASSERT_EQUAL(binaryRequests[i].data, textRequests[i].data);
+	}
+
+	// The binary trace is read as binary and converts to itself
+	trace = openTrace(BINARY_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_TRUE(trace->binary);
+	CU_ASSERT_EQUAL(writeBinaryTrace(trace, TEXT_TRACE), count);
+	closeTrace(trace);
+	CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 4, textRequests, 16, &failed), count);
+	CU_ASSERT_FALSE(failed);
+	for (uint32_t i = 0; i < count; i++) {
+		CU_ASSERT_EQUAL(textRequests[i].op, expected[i].op);
+		CU_ASSERT_EQUAL(textRequests[i].address, expected[i].address);
+		CU_ASSERT_EQUAL(textRequests[i].size, expected[i].size);
+		CU_ASSERT_EQUAL(textRequests[i].data, expected[i].data);
+	}
+
+	// A text trace that cannot be parsed is not converted
+	writeFile(TEXT_TRACE, "0x10 zz\n", 8);
+	trace = openTrace(TEXT_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_EQUAL(writeBinaryTrace(trace, BINARY_TRACE), -1);
+	closeTrace(trace);
+	remove(TEXT_TRACE);
+	remove(BINARY_TRACE);
+}
+
+/*
+	Tests that binary traces which are cut short or have a bad header are
+	rejected, keeping the records before the error.
+*/
+void test_BinaryErrors() {
+	cacheRequest_t requests[4];
+	bool failed;
+
+	// A header with the wrong magic or version is not binary, so it fails as text
+	uint8_t badMagic[] = {'C', 'T', 'R', 'X', 1, 0, 0x80, 0x80, 0x80, 0x9c, 0x0c};
+	writeFile(BINARY_TRACE, badMagic, sizeof(badMagic));
+	traceReader_t* trace = openTrace(BINARY_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_FALSE(trace->binary);
+	CU_ASSERT_EQUAL(readTrace(trace, requests, 4), 0);
+	CU_ASSERT_TRUE(trace->failed);
+	closeTrace(trace);
+	uint8_t badVersion[] = {'C', 'T', 'R', 'C', 2, 0, 0x80, 0x80, 0x80, 0x9c, 0x0c};
+	writeFile(BINARY_TRACE, badVersion, sizeof(badVersion));
+	trace = openTrace(BINARY_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_FALSE(trace->binary);
+	CU_ASSERT_EQUAL(readTrace(trace, requests, 4), 0);
+	CU_ASSERT_TRUE(trace->failed);
+	closeTrace(trace);
+
+	// With the right version the same bytes are one byte read of MIN_ADDRESS
+	badVersion[4] = 1;
+	writeFile(BINARY_TRACE, badVersion, sizeof(badVersion));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 1);
+	CU_ASSERT_FALSE(failed);
+	CU_ASSERT_EQUAL(requests[0].op, READ_ACCESS);
+	CU_ASSERT_EQUAL(requests[0].address, 0x61c00000);
+	CU_ASSERT_EQUAL(requests[0].size, 1);
+
+	// An empty binary trace has no records
+	writeFile(BINARY_TRACE, badVersion, 5);
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 0);
+	CU_ASSERT_FALSE(failed);
+
+	// The address varint ends in the middle
+	uint8_t truncatedVarint[] = {'C', 'T', 'R', 'C', 1, 0, 0x80, 0x80};
+	writeFile(BINARY_TRACE, truncatedVarint, sizeof(truncatedVarint));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 0);
+	CU_ASSERT_TRUE(failed);
+
+	// A varint longer than 64 bits
+	uint8_t longVarint[] = {'C', 'T', 'R', 'C', 1, 0, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 1};
+	writeFile(BINARY_TRACE, longVarint, sizeof(longVarint));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 0);
+	CU_ASSERT_TRUE(failed);
+
+	// An address step that does not fit in 32 bits
+	uint8_t wideStep[] = {'C', 'T', 'R', 'C', 1, 0, 0x80, 0x80, 0x80, 0x80, 0x20};
+	writeFile(BINARY_TRACE, wideStep, sizeof(wideStep));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 0);
+	CU_ASSERT_TRUE(failed);
+
+	// The second record is a write that ends before its data
+	uint8_t midRecord[] = {'C', 'T', 'R', 'C', 1, 4, 0x80, 0x80, 0x80, 0x9c, 0x0c, 5, 0x10};
+	writeFile(BINARY_TRACE, midRecord, sizeof(midRecord));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 1);
+	CU_ASSERT_TRUE(failed);
+	CU_ASSERT_EQUAL(requests[0].address, 0x61c00000);
+	CU_ASSERT_EQUAL(requests[0].size, 4);
+
+	// The second record ends before its size, which is not a power of 2
+	uint8_t midSize[] = {'C', 'T', 'R', 'C', 1, 4, 0x80, 0x80, 0x80, 0x9c, 0x0c, 8};
+	writeFile(BINARY_TRACE, midSize, sizeof(midSize));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 1);
+	CU_ASSERT_TRUE(failed);
+
+	// Nothing more is read once a trace has failed
+	trace = openTrace(BINARY_TRACE, 4);
+	CU_ASSERT_EQUAL(readTrace(trace, requests, 4), 1);
+	CU_ASSERT_TRUE(trace->failed);
+	CU_ASSERT_EQUAL(readTrace(trace, requests, 4), 0);
+	closeTrace(trace);
+
+	// Steps down are zigzag encoded: +0x61c00010 then -0x10, -1, and +1
+	uint8_t steps[] = {'C', 'T', 'R', 'C', 1, 0, 0xa0, 0x80, 0x80, 0x9c, 0x0c, 0, 0x1f, 0, 1, 0, 2};
+	writeFile(BINARY_TRACE, steps, sizeof(steps));
+	CU_ASSERT_EQUAL(readWholeTrace(BINARY_TRACE, 4, requests, 4, &failed), 4);
+	CU_ASSERT_FALSE(failed);
+	CU_ASSERT_EQUAL(requests[0].address, 0x61c00010);
+	CU_ASSERT_EQUAL(requests[1].address, 0x61c00000);
+	CU_ASSERT_EQUAL(requests[2].address, 0x61bfffff);
+	CU_ASSERT_EQUAL(requests[3].address, 0x61c00000);
+	remove(BINARY_TRACE);
+}
+
+/*
+	Tests that the next uses found from a trace follow the accesses
+	accessBatch makes, one per block of a request wider than a block, one
+	for a request within a block, and none for an invalid request.
+*/
+void test_NextUses() {
+	char* text = "R 0x61c00000 4\n"
+		"R 0x61c00010 8\n"
+		"R 0x61c00014 2\n"
+		"W 0x61c00002 1 ff\n"
+		"# not aligned, then not a power of 2\n"
+		"R 0x61c00001 4\n"
+		"R 0x61c00100 4\n"
+		"R 0x61c00010 3\n"
+		"R 0x61c00011 1\n";
+	// Blocks 0, 4, 5, 5, 0, 64, 4 with 4 byte blocks and 0, 2, 2, 0, 32, 2 with 8 byte blocks
+	uint32_t narrow[] = {4, 6, 3, OPT_NEVER, OPT_NEVER, OPT_NEVER, OPT_NEVER};
+	uint32_t wide[] = {3, 2, 5, OPT_NEVER, OPT_NEVER, OPT_NEVER};
+	uint64_t count = 0;
+	writeFile(TEXT_TRACE, text, strlen(text));
+
+	uint32_t* nextUses = findNextUses(TEXT_TRACE, 4, 4, &count);
+	CU_ASSERT_PTR_NOT_NULL(nextUses);
+	CU_ASSERT_EQUAL(count, 7);
+	for (uint32_t i = 0; nextUses != NULL && i < 7; i++) {
+		CU_ASSERT_EQUAL(nextUses[i], narrow[i]);
+	}
+	free(nextUses);
+	nextUses = findNextUses(TEXT_TRACE, 4, 8, &count);
+	CU_ASSERT_PTR_NOT_NULL(nextUses);
+	CU_ASSERT_EQUAL(count, 6);
+	for (uint32_t i = 0; nextUses != NULL && i < 6; i++) {
+		CU_ASSERT_EQUAL(nextUses[i], wide[i]);
+	}
+	free(nextUses);
+
+	// The same requests already decoded give the same next uses
+	cacheRequest_t requests[16];
+	bool failed;
+	CU_ASSERT_EQUAL(readWholeTrace(TEXT_TRACE, 4, requests, 16, &failed), 8);
+	CU_ASSERT_FALSE(failed);
+	nextUses = findRequestNextUses(requests, 8, 4, &count);
+	CU_ASSERT_PTR_NOT_NULL(nextUses);
+	CU_ASSERT_EQUAL(count, 7);
+	for (uint32_t i = 0; nextUses != NULL && i < 7; i++) {
+		CU_ASSERT_EQUAL(nextUses[i], narrow[i]);
+	}
+	free(nextUses);
+
+	// A trace of nothing valid has no accesses
+	writeFile(TEXT_TRACE, "R 0x61c00003 2\n", 15);
+	nextUses = findNextUses(TEXT_TRACE, 4, 4, &count);
+	CU_ASSERT_PTR_NOT_NULL(nextUses);
+	CU_ASSERT_EQUAL(count, 0);
+	free(nextUses);
+
+	// Traces that cannot be read give no next uses
+	writeFile(TEXT_TRACE, "R 0x61c00000 4 zz\n", 18);
+	CU_ASSERT_PTR_NULL(findNextUses(TEXT_TRACE, 4, 4, &count));
+	CU_ASSERT_PTR_NULL(findNextUses("testFiles/missingTrace.txt", 4, 4, &count));
+	remove(TEXT_TRACE);
+}
+
+/*
+	Takes in a decoded trace, the memory to start from, and a configuration
+	and replays the trace through a cache of its own with accessBatch, in
+	the way cachesim replays a single cache, filling in the results of the
+	configuration.
+*/
+static void replayConfig(sweepTrace_t* trace, physicalMemory_t* memory, sweepConfig_t* config) {
+	cacheOptions_t options = defaultCacheOptions();
+	options.policy = config->policy;
+	options.classifyMisses = true;
+	uint32_t* nextUses = NULL;
+	uint64_t uses = 0;
+	if (config->policy == OPT_POLICY) {
+		nextUses = findRequestNextUses(trace->requests, trace->count, config->blockDataSize, &uses);
+		CU_ASSERT_PTR_NOT_NULL(nextUses);
+	}
+	physicalMemory_t* copy = copyPhysicalMemory(memory);
+	cache_t* cache = createCacheWithOptions(config->n, config->blockDataSize, config->totalDataSize, copy, &options);
+	releasePhysicalMemory(copy);
+	config->valid = cache != NULL;
+	if (cache == NULL) {
+		free(nextUses);
+		return;
+	}
+	setNextUses(cache, nextUses, uses);
+	cacheResult_t* results = malloc(sizeof(cacheResult_t) * trace->count);
+	CU_ASSERT_PTR_NOT_NULL(results);
+	CU_ASSERT_EQUAL(accessBatch(cache, trace->requests, results, trace->count), trace->count);
+	config->access = cache->access;
+	config->hit = cache->hit;
+	config->compulsory = cache->misses->compulsory;
+	config->capacity = cache->misses->capacity;
+	config->conflict = cache->misses->conflict;
+	free(results);
+	deleteCache(cache);
+	free(nextUses);
+}
+
+/*
+	Tests that a sweep gives every configuration the results of replaying
+	the trace through that cache alone, whether it runs on one thread or
+	on many, including OPT, which finds its next uses from the decoded
+	trace.
+*/
+void test_Sweep() {
+	sweepConfig_t configs[] = {
+		{1, 8, 64, LRU_POLICY},
+		{2, 8, 64, LRU_POLICY},
+		{4, 16, 256, PLRU_POLICY},
+		{4, 16, 256, SRRIP_POLICY},
+		{8, 32, 1024, DRRIP_POLICY},
+		{2, 16, 128, FIFO_POLICY},
+		{4, 8, 128, RANDOM_POLICY},
+		{4, 8, 128, LFU_POLICY},
+		{4, 8, 128, CLOCK_POLICY},
+		{4, 8, 128, NRU_POLICY},
+		{2, 8, 64, OPT_POLICY},
+		{4, 16, 256, OPT_POLICY},
+		{16, 4, 64, OPT_POLICY},
+		{3, 8, 64, LRU_POLICY},
+	};
+	uint32_t count = sizeof(configs) / sizeof(sweepConfig_t);
+	uint32_t requests = 10000;
+	uint32_t threadCounts[] = {1, 4, 64};
+	sweepConfig_t expected[sizeof(configs) / sizeof(sweepConfig_t)];
+	sweepConfig_t swept[sizeof(configs) / sizeof(sweepConfig_t)];
+
+	// Mostly nearby words with some wider and narrower accesses, so every cache misses a fair amount
+	FILE* file = fopen(TEXT_TRACE, "w");
+	CU_ASSERT_PTR_NOT_NULL(file);
+	srand(61);
+	for (uint32_t i = 0; i < requests; i++) {
+		uint32_t size = 1 << (rand() % 4);
+		uint32_t address = (rand() % 2048) & ~(size - 1);
+		if (rand() % 4 == 0) {
+			fprintf(file, "W %x %u %x\n", address, size, rand());
+		} else {
+			fprintf(file, "R %x %u\n", address, size);
+		}
+	}
+	fclose(file);
+	sweepTrace_t* trace = loadSweepTrace(TEXT_TRACE, 4);
+	CU_ASSERT_PTR_NOT_NULL(trace);
+	CU_ASSERT_EQUAL(trace->count, requests);
+	physicalMemory_t* memory = openPrivatePhysicalMemory("testFiles/physicalMemory1.txt");
+	CU_ASSERT_PTR_NOT_NULL(memory);
+
+	for (uint32_t i = 0; i < count; i++) {
+		expected[i] = configs[i];
+		replayConfig(trace, memory, &expected[i]);
+		CU_ASSERT_EQUAL(expected[i].valid, i != count - 1);
+	}
+	for (uint32_t t = 0; t < sizeof(threadCounts) / sizeof(uint32_t); t++) {
+		memcpy(swept, configs, sizeof(configs));
+		runSweep(trace, memory, swept, count, threadCounts[t]);
+		for (uint32_t i = 0; i < count; i++) {
+			CU_ASSERT_EQUAL(swept[i].valid, expected[i].valid);
+			if (!expected[i].valid) {
+				continue;
+			}
+			CU_ASSERT_EQUAL(swept[i].access, expected[i].access);
+			CU_ASSERT_EQUAL(swept[i].hit, expected[i].hit);
+			CU_ASSERT_EQUAL(swept[i].compulsory, expected[i].compulsory);
+			CU_ASSERT_EQUAL(swept[i].capacity, expected[i].capacity);
+			CU_ASSERT_EQUAL(swept[i].conflict, expected[i].conflict);
+			CU_ASSERT_EQUAL(swept[i].access - swept[i].hit,
+				swept[i].compulsory + swept[i].capacity + swept[i].conflict);
+		}
+	}
+
+	// OPT never misses more than LRU on the same cache
+	CU_ASSERT_TRUE(expected[10].hit >= expected[1].hit);
+	CU_ASSERT_TRUE(expected[0].hit < expected[0].access);
+	releasePhysicalMemory(memory);
+	deleteSweepTrace(trace);
+	remove(TEXT_TRACE);
+}
+
+int main() {
+	CU_pSuite pSuite1 = NULL;
+	CU_pSuite pSuite2 = NULL;
+	if (CUE_SUCCESS != CU_initialize_registry()) {
+		return CU_get_error();
+	}
+	pSuite1 = CU_add_suite("Testing Traces", NULL, NULL);
+	if (!pSuite1) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite1, "test_TextTrace", test_TextTrace)) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite1, "test_TextTraceBoundary", test_TextTraceBoundary)) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite1, "test_TextTraceErrors", test_TextTraceErrors)) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite1, "test_BinaryRoundTrip", test_BinaryRoundTrip)) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite1, "test_BinaryErrors", test_BinaryErrors)) {
+		goto exit;
+	}
+	pSuite2 = CU_add_suite("Testing OPT and Sweeps", NULL, NULL);
+	if (!pSuite2) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite2, "test_NextUses", test_NextUses)) {
+		goto exit;
+	}
+	if (!CU_add_test(pSuite2, "test_Sweep", test_Sweep)) {
+		goto exit;
+	}
+	CU_basic_set_mode(CU_BRM_VERBOSE);
+	CU_basic_run_tests();
+
+exit:
+	CU_cleanup_registry();
+	return CU_get_error();
+}